@@ -0,0 +1,54 @@
+// Cache-first service worker for the Pyodide runtime (see src/lib/pyodideRuntime.ts).
+//
+// The page registers this script as sw.js?pyodide=<index URL>. Everything under that URL
+// is versioned and immutable: the WASM binary, the stdlib zip, the lock file and the
+// wheels. So each is fetched from the CDN once and then served from Cache Storage. A new
+// Pyodide version changes the registration URL, which installs a fresh worker with a
+// fresh cache and deletes the old one.
+const INDEX_URL = new URL(self.location.href).searchParams.get('pyodide') || '';
+const CACHE_PREFIX = 'servoom-pyodide-runtime:';
+const CACHE = CACHE_PREFIX + INDEX_URL;
+// Fetched up front so even the first cold start after install is served locally.
+const CORE_FILES = ['pyodide.asm.js', 'pyodide.asm.wasm', 'python_stdlib.zip', 'pyodide-lock.json'];
+
+self.addEventListener('install', (event) => {
+  self.skipWaiting();
+  if (!INDEX_URL) return;
+  // Best effort: a failed precache must not block installation
+  event.waitUntil(
+    caches
+      .open(CACHE)
+      .then((cache) => Promise.all(CORE_FILES.map((name) => store(cache, new Request(INDEX_URL + name)))))
+      .catch(() => undefined),
+  );
+});
+
+self.addEventListener('activate', (event) => {
+  event.waitUntil(
+    caches
+      .keys()
+      .then((keys) =>
+        Promise.all(
+          keys.filter((key) => key.startsWith(CACHE_PREFIX) && key !== CACHE).map((key) => caches.delete(key)),
+        ),
+      )
+      .then(() => self.clients.claim()),
+  );
+});
+
+self.addEventListener('fetch', (event) => {
+  const { request } = event;
+  if (!INDEX_URL || request.method !== 'GET' || !request.url.startsWith(INDEX_URL)) return;
+  event.respondWith(
+    caches.open(CACHE).then(async (cache) => (await cache.match(request.url)) || store(cache, request)),
+  );
+});
+
+async function store(cache, request) {
+  const response = await fetch(request);
+  // Opaque responses would be blocked by the page's COEP anyway; never cache them
+  if (response.ok && response.type !== 'opaque') {
+    await cache.put(request.url, response.clone());
+  }
+  return response;
+}
@@ -17,6 +17,8 @@ import {
 } from './lib/divoomApi';
 import { PyodideDecoder, type DecodedBean } from './lib/pyodideDecoder';
 import { layerFileToPsd } from './lib/layerFile';
+import { acquireBitmaps, releaseBitmaps, startPlayback } from './lib/previewEngine';
+import { inOrder, requestScheduler, type Lane } from './lib/requestScheduler';
 import logger from './lib/logger';
 
 interface DecodeState {
@@ -836,64 +838,35 @@ function blobDownload(data: Uint8Array, filename: string) {
   URL.revokeObjectURL(url);
 }
 
-function rgbToRgba(frame: Uint8Array, width: number, height: number): ImageData {
-  const rgba = new Uint8ClampedArray(width * height * 4);
-  let src = 0;
-  for (let i = 0; i < rgba.length; i += 4) {
-    rgba[i] = frame[src++];
-    rgba[i + 1] = frame[src++];
-    rgba[i + 2] = frame[src++];
-    rgba[i + 3] = 255;
-  }
-  return new ImageData(rgba, width, height);
-}
-
 function AnimationPreview({ bean, scale }: { bean: DecodedBean; scale: number }) {
   const canvasRef = useRef<HTMLCanvasElement | null>(null);
   const width = bean.columnCount * 16;
   const height = bean.rowCount * 16;
-  const imageFrames = useMemo(
-    () => bean.frames.map((frame) => rgbToRgba(frame, width, height)),
-    [bean.frames, width, height],
-  );
+  // Keyed by bean so a new bean never plays the previous one's bitmaps
+  const [loaded, setLoaded] = useState<{ bean: DecodedBean; bitmaps: ImageBitmap[] } | null>(null);
+  const bitmaps = loaded?.bean === bean ? loaded.bitmaps : null;
+
+  useEffect(() => {
+    let cancelled = false;
+    acquireBitmaps(bean)
+      .then((converted) => {
+        if (!cancelled) setLoaded({ bean, bitmaps: converted });
+      })
+      .catch((error) => logger.error('Preview conversion failed', error));
+    return () => {
+      cancelled = true;
+      releaseBitmaps(bean);
+    };
+  }, [bean]);
 
   useEffect(() => {
     const canvas = canvasRef.current;
     if (!canvas) return;
     canvas.width = width * scale;
     canvas.height = height * scale;
-  }, [width, height, scale]);
-
-  useEffect(() => {
-    const canvas = canvasRef.current;
-    if (!canvas || imageFrames.length === 0) return;
-    const ctx = canvas.getContext('2d');
-    if (!ctx) return;
-    ctx.imageSmoothingEnabled = false;
-
-    const offscreen = document.createElement('canvas');
-    offscreen.width = width;
-    offscreen.height = height;
-    const offCtx = offscreen.getContext('2d');
-    if (!offCtx) return;
-    offCtx.imageSmoothingEnabled = false;
-
-    let frameIndex = 0;
-    let timeoutId: number;
-
-    const render = () => {
-      offCtx.putImageData(imageFrames[frameIndex], 0, 0);
-      ctx.clearRect(0, 0, canvas.width, canvas.height);
-      ctx.drawImage(offscreen, 0, 0, canvas.width, canvas.height);
-      frameIndex = (frameIndex + 1) % imageFrames.length;
-      timeoutId = window.setTimeout(render, bean.speed || 40);
-    };
-
-    render();
-    return () => {
-      window.clearTimeout(timeoutId);
-    };
-  }, [bean.speed, imageFrames, width, height, scale]);
+    if (!bitmaps) return;
+    return startPlayback(canvas, bitmaps, bean.speed);
+  }, [bean.speed, bitmaps, width, height, scale]);
 
   return <canvas ref={canvasRef} className="preview-canvas" />;
 }
@@ -904,6 +877,9 @@ function App() {
   const decodedCache = useRef<Map<number, DecodedBean>>(new Map());
   const layerDownloadCache = useRef<Map<number, Uint8Array>>(new Map());
 
+  // Boot Pyodide while the user is still logging in, not on their first preview click.
+  useEffect(() => decoder.warmUp(), [decoder]);
+
   const [locale, setLocale] = useState<Locale>('en');
   const t = translations[locale];
 
@@ -951,7 +927,7 @@ function App() {
   const [decodingItemId, setDecodingItemId] = useState<number | null>(null);
   const [layerBusyItemId, setLayerBusyItemId] = useState<number | null>(null);
   const zipCacheRef = useRef<{ url: string; filename: string } | null>(null);
-  const cancelRef = useRef(false);
+  const cancelRef = useRef<AbortController | null>(null);
 
   useEffect(() => {
     return () => {
@@ -1017,7 +993,7 @@ function App() {
 
   const handleCancelFetch = () => {
     if (!itemsLoading) return;
-    cancelRef.current = true;
+    cancelRef.current?.abort();
     setStatus({ type: 'cancelFetch' });
     setItemsLoading(false);
   };
@@ -1117,33 +1093,35 @@ function App() {
   const fetchInBatches = async (
     start: number,
     count: number,
-    loader: (chunkStart: number, chunkEnd: number) => Promise<GalleryInfo[]>,
+    loader: (chunkStart: number, chunkEnd: number, signal?: AbortSignal) => Promise<GalleryInfo[]>,
     options?: {
       onProgress?: (info: { chunk: number; start: number; end: number }) => void;
-      isCancelled?: () => boolean;
+      signal?: AbortSignal;
     },
   ): Promise<GalleryInfo[]> => {
     const targetCount = Math.min(MAX_ITEMS, count);
     const collected: GalleryInfo[] = [];
     const seen = new Set<string | number>();
-    let cursor = start;
-    let remaining = targetCount;
-    let attempts = 0;
     const maxAttempts = Math.ceil(targetCount / API_BATCH_LIMIT) + 5;
-    let chunkIndex = 0;
-
-    while (remaining > 0 && attempts < maxAttempts) {
-      if (options?.isCancelled?.()) {
-        throw new CancelledError();
-      }
-      attempts += 1;
-      const chunkSize = Math.min(API_BATCH_LIMIT, remaining);
-      const chunkEnd = cursor + chunkSize - 1;
-      chunkIndex += 1;
-      options?.onProgress?.({ chunk: chunkIndex, start: cursor, end: chunkEnd });
+    const lastPlanned = start + targetCount - 1;
+    // Aborted on cancel, and once the walk stops, to drop windows issued past the end
+    const local = new AbortController();
+    const abortLocal = () => local.abort();
+    options?.signal?.addEventListener('abort', abortLocal, { once: true });
+
+    type Span = { chunk: number; start: number; end: number };
+    const load = (span: Span) =>
+      requestScheduler.schedule(
+        'listing',
+        (signal) => {
+          options?.onProgress?.(span);
+          return loader(span.start, span.end, signal);
+        },
+        local.signal,
+      );
+    // Merge one window's items; false once the walk should stop.
+    const merge = (batch: GalleryInfo[]) => {
       const before = collected.length;
-      const batch = await loader(cursor, chunkEnd);
-
       for (const item of batch) {
         const key =
           item.GalleryId ??
@@ -1152,13 +1130,40 @@ function App() {
         seen.add(key);
         collected.push(item);
       }
+      return batch.length > 0 && collected.length > before && collected.length < targetCount;
+    };
 
-      if (batch.length === 0) break;
-      if (collected.length === before) break;
-      if (collected.length >= targetCount) break;
-
-      cursor += chunkSize;
-      remaining = targetCount - collected.length;
+    try {
+      // The windows covering the range are requested concurrently and merged strictly in
+      // order, so dedup and the stop rules see exactly what a sequential walk would.
+      const planned: Span[] = [];
+      for (let cursor = start; cursor <= lastPlanned; cursor += API_BATCH_LIMIT) {
+        planned.push({
+          chunk: planned.length + 1,
+          start: cursor,
+          end: Math.min(cursor + API_BATCH_LIMIT - 1, lastPlanned),
+        });
+      }
+      let more = true;
+      for await (const batch of inOrder(planned, load)) {
+        more = merge(batch);
+        if (!more) break;
+      }
+      // Duplicates left us short: keep going one window at a time, as before
+      let cursor = lastPlanned + 1;
+      for (let chunk = planned.length + 1; more && chunk <= maxAttempts; chunk += 1) {
+        const chunkSize = Math.min(API_BATCH_LIMIT, targetCount - collected.length);
+        more = merge(await load({ chunk, start: cursor, end: cursor + chunkSize - 1 }));
+        cursor += chunkSize;
+      }
+    } catch (err) {
+      if (options?.signal?.aborted) {
+        throw new CancelledError();
+      }
+      throw err;
+    } finally {
+      options?.signal?.removeEventListener('abort', abortLocal);
+      local.abort();
     }
 
     return collected.slice(0, targetCount);
@@ -1169,7 +1174,8 @@ function App() {
     setItemsLoading(true);
     setError(null);
     const { start, count } = normalizedRange;
-    cancelRef.current = false;
+    const controller = new AbortController();
+    cancelRef.current = controller;
     setStatus({ type: 'userStart' });
     let clearStatus = true;
     try {
@@ -1177,12 +1183,13 @@ function App() {
       const files = await fetchInBatches(
         start,
         count,
-        (chunkStart, chunkEnd) => fetchUserGallery(session, session.userId, chunkStart, chunkEnd),
+        (chunkStart, chunkEnd, signal) =>
+          fetchUserGallery(session, session.userId, chunkStart, chunkEnd, signal),
         {
           onProgress: ({ chunk, start: chunkStart, end: chunkEnd }) => {
             setStatus({ type: 'userBatch', chunk, start: chunkStart, end: chunkEnd });
           },
-          isCancelled: () => cancelRef.current,
+          signal: controller.signal,
         },
       );
       resetDataset(files, {
@@ -1208,7 +1215,9 @@ function App() {
         }
       }
     } finally {
-      cancelRef.current = false;
+      if (cancelRef.current === controller) {
+        cancelRef.current = null;
+      }
       if (clearStatus) {
         setStatus(null);
       }
@@ -1216,7 +1225,11 @@ function App() {
     }
   };
 
-  const fetchRaw = async (item: GalleryInfo): Promise<Uint8Array> => {
+  // Downloads go through the shared scheduler: clicks use the 'preview' lane, which
+  // overtakes queued 'bulk' ZIP downloads.
+  type FetchOptions = { lane?: Lane; signal?: AbortSignal };
+
+  const fetchRaw = async (item: GalleryInfo, options?: FetchOptions): Promise<Uint8Array> => {
     const cached = downloadCache.current.get(item.GalleryId);
     if (cached) {
       logger.info('Using cached binary', { galleryId: item.GalleryId });
@@ -1225,7 +1238,11 @@ function App() {
     setStatus({ type: 'downloadBinary' });
     logger.info('Downloading binary', { galleryId: item.GalleryId, fileId: item.FileId });
     try {
-      const data = await downloadBinary(item.FileId);
+      const data = await requestScheduler.schedule(
+        options?.lane ?? 'preview',
+        (signal) => downloadBinary(item.FileId, signal),
+        options?.signal,
+      );
       downloadCache.current.set(item.GalleryId, data);
       logger.info('Binary downloaded', { galleryId: item.GalleryId, bytes: data.length });
       return data;
@@ -1234,7 +1251,7 @@ function App() {
     }
   };
 
-  const fetchLayerRaw = async (item: GalleryInfo): Promise<Uint8Array> => {
+  const fetchLayerRaw = async (item: GalleryInfo, options?: FetchOptions): Promise<Uint8Array> => {
     const cached = layerDownloadCache.current.get(item.GalleryId);
     if (cached) {
       return cached;
@@ -1245,7 +1262,11 @@ function App() {
     }
     setStatus({ type: 'downloadBinary' });
     try {
-      const data = await downloadBinary(layerId);
+      const data = await requestScheduler.schedule(
+        options?.lane ?? 'preview',
+        (signal) => downloadBinary(layerId, signal),
+        options?.signal,
+      );
       layerDownloadCache.current.set(item.GalleryId, data);
       logger.info('Layer binary downloaded', { galleryId: item.GalleryId, bytes: data.length });
       return data;
@@ -1335,22 +1356,28 @@ function App() {
     }
   };
 
-  const handleDownloadWebp = () => {
+  const handleDownloadWebp = async () => {
     if (!decodeState) return;
-    blobDownload(
-      decodeState.bean.webp,
-      `${safeName(decodeState.item)}_${decodeState.item.GalleryId}.webp`,
-    );
-    logger.info('WebP download triggered', { galleryId: decodeState.item.GalleryId });
+    try {
+      const { webp } = await decoder.exports(decodeState.bean);
+      blobDownload(webp, `${safeName(decodeState.item)}_${decodeState.item.GalleryId}.webp`);
+      logger.info('WebP download triggered', { galleryId: decodeState.item.GalleryId });
+    } catch (err) {
+      logger.error('WebP export failed', err);
+      setError({ type: 'generic', message: (err as Error).message });
+    }
   };
 
-  const handleDownloadGif = () => {
+  const handleDownloadGif = async () => {
     if (!decodeState) return;
-    blobDownload(
-      decodeState.bean.gif,
-      `${safeName(decodeState.item)}_${decodeState.item.GalleryId}.gif`,
-    );
-    logger.info('GIF download triggered', { galleryId: decodeState.item.GalleryId });
+    try {
+      const { gif } = await decoder.exports(decodeState.bean);
+      blobDownload(gif, `${safeName(decodeState.item)}_${decodeState.item.GalleryId}.gif`);
+      logger.info('GIF download triggered', { galleryId: decodeState.item.GalleryId });
+    } catch (err) {
+      logger.error('GIF export failed', err);
+      setError({ type: 'generic', message: (err as Error).message });
+    }
   };
 
   const handleCheckboxChange = (galleryId: number, checked: boolean) => {
@@ -1375,6 +1402,8 @@ function App() {
     setIsZipping(true);
     setError(null);
     setZipStatus({ type: 'init' });
+    // Stops downloads still queued or in flight when the export fails
+    const zipAbort = new AbortController();
     try {
       logger.info('Preparing ZIP', { selectionCount });
       const zip = new JSZip();
@@ -1399,12 +1428,22 @@ function App() {
       }
       const needArtwork = zipOptions.dat || zipOptions.webp || zipOptions.gif;
       const needLayer = zipOptions.layerDat || zipOptions.layerPsd;
-      for (let i = 0; i < selectedItems.length; i += 1) {
-        const item = selectedItems[i];
+      // Downloads run ahead concurrently in the 'bulk' lane; decoding and ZIP assembly
+      // consume them in selection order.
+      const downloads = inOrder(selectedItems, async (item) => {
+        const fetchOptions: FetchOptions = { lane: 'bulk', signal: zipAbort.signal };
+        const [raw, layerRaw] = await Promise.all([
+          needArtwork ? fetchRaw(item, fetchOptions) : null,
+          needLayer && hasLayerFile(item) ? fetchLayerRaw(item, fetchOptions) : null,
+        ]);
+        return { item, raw, layerRaw };
+      });
+      let current = 0;
+      for await (const { item, raw, layerRaw } of downloads) {
+        current += 1;
         const progressLabel = item.FileName || `Gallery ${item.GalleryId}`;
-        setZipStatus({ type: 'progress', current: i + 1, total: selectionCount, label: progressLabel });
-        if (needArtwork) {
-          const raw = await fetchRaw(item);
+        setZipStatus({ type: 'progress', current, total: selectionCount, label: progressLabel });
+        if (raw) {
           if (zipOptions.dat && datFolder) {
             datFolder.file(`${safeName(item)}_${item.GalleryId}.dat`, raw);
           }
@@ -1414,16 +1453,16 @@ function App() {
               bean = await decoder.decode(raw);
               decodedCache.current.set(item.GalleryId, bean);
             }
+            const { webp, gif } = await decoder.exports(bean);
             if (zipOptions.webp && webpFolder) {
-              webpFolder.file(`${safeName(item)}_${item.GalleryId}.webp`, bean.webp);
+              webpFolder.file(`${safeName(item)}_${item.GalleryId}.webp`, webp);
             }
             if (zipOptions.gif && gifFolder) {
-              gifFolder.file(`${safeName(item)}_${item.GalleryId}.gif`, bean.gif);
+              gifFolder.file(`${safeName(item)}_${item.GalleryId}.gif`, gif);
             }
           }
         }
-        if (needLayer && hasLayerFile(item)) {
-          const layerRaw = await fetchLayerRaw(item);
+        if (layerRaw) {
           if (zipOptions.layerDat && layerDatFolder) {
             layerDatFolder.file(`${safeName(item)}_${item.GalleryId}_layer.dat`, layerRaw);
           }
@@ -1458,6 +1497,7 @@ function App() {
       }
       setZipStatus({ type: 'failed' });
     } finally {
+      zipAbort.abort();
       setIsZipping(false);
     }
   };
@@ -52,11 +52,16 @@ export class ApiError extends Error {
   }
 }
 
-async function postJson<T>(url: string, body: Record<string, unknown>): Promise<T> {
+async function postJson<T>(
+  url: string,
+  body: Record<string, unknown>,
+  signal?: AbortSignal,
+): Promise<T> {
   const resp = await fetch(url, {
     method: 'POST',
     headers: DEFAULT_HEADERS,
     body: JSON.stringify(body),
+    signal,
   });
   if (!resp.ok) {
     throw new Error(`Request failed with status ${resp.status}`);
@@ -153,6 +158,7 @@ export async function fetchUserGallery(
   userId: number,
   start = 1,
   end = 60,
+  signal?: AbortSignal,
 ): Promise<GalleryInfo[]> {
   const payload = {
     StartNum: start,
@@ -170,7 +176,7 @@ export async function fetchUserGallery(
   const response = await postJson<{
     ReturnCode: number;
     FileList: GalleryInfo[];
-  }>(`${API_BASE}/GetSomeoneListV2`, payload);
+  }>(`${API_BASE}/GetSomeoneListV2`, payload, signal);
 
   if (response.ReturnCode !== 0) {
     throw new ApiError('userGallery', response.ReturnCode);
@@ -178,9 +184,9 @@ export async function fetchUserGallery(
   return (response.FileList ?? []).filter(item => !shouldExcludeHidden(item));
 }
 
-export async function downloadBinary(fileId: string): Promise<Uint8Array> {
+export async function downloadBinary(fileId: string, signal?: AbortSignal): Promise<Uint8Array> {
   const normalized = fileId.startsWith('/') ? fileId : `/${fileId}`;
-  const resp = await fetch(`${FILE_BASE}${normalized}`);
+  const resp = await fetch(`${FILE_BASE}${normalized}`, { signal });
   if (!resp.ok) {
     throw new Error(`File download failed with status ${resp.status}`);
   }
@@ -0,0 +1,23 @@
+// Runs decodeEmbeddedImages (formats 31/41/43) off the main thread.
+import { decodeEmbeddedImages } from './embeddedImages';
+import type { NativeFrames } from './embeddedImages';
+
+// The app compiles against the DOM lib only; this is the slice of the worker scope used here.
+const scope = self as unknown as {
+  onmessage: ((event: MessageEvent<{ id: number; raw: Uint8Array }>) => void) | null;
+  postMessage(
+    message: { id: number; result?: NativeFrames | null; error?: string },
+    transfer?: Transferable[],
+  ): void;
+};
+
+scope.onmessage = async (event) => {
+  const { id, raw } = event.data;
+  try {
+    const result = await decodeEmbeddedImages(raw);
+    const transfer = result ? result.frames.map((frame) => frame.buffer as ArrayBuffer) : [];
+    scope.postMessage({ id, result }, transfer);
+  } catch (error) {
+    scope.postMessage({ id, error: String(error) });
+  }
+};
@@ -0,0 +1,279 @@
+// Browser-native decoding for the formats that embed standard images:
+//   31  JPEG sequence            (Decoder0x1F)
+//   41  JPEG sequence, 256x256   (Format41Decoder)
+//   43  embedded GIF / WebP      (AnimEmbeddedImageDecoder)
+// The container scan mirrors the Python decoders byte for byte; images go through the
+// browser's codecs (createImageBitmap, WebCodecs ImageDecoder for animations) on an
+// OffscreenCanvas, composited like _composite_image_sequence. Pixel values can differ
+// from Pillow by IDCT/blend rounding. Anything else returns null and stays in Pyodide.
+import logger from './logger';
+
+export interface NativeFrames {
+  totalFrames: number;
+  speed: number;
+  rowCount: number;
+  columnCount: number;
+  frames: Uint8Array[];
+}
+
+export const NATIVE_FORMATS = new Set([31, 41, 43]);
+
+const SOI = [0xff, 0xd8];
+const EOI = [0xff, 0xd9];
+const GAP_PREFIX = [0x02, 0x00, 0x00];
+const FORMAT_41_RESERVED = 9;
+
+// WebCodecs ImageDecoder is not in every TS DOM lib yet; this is the part used here.
+interface ImageDecoderLike {
+  tracks: { ready: Promise<void>; selectedTrack: { frameCount: number } | null };
+  completed: Promise<void>;
+  decode(options: { frameIndex: number }): Promise<{ image: VideoFrame }>;
+  close(): void;
+}
+type ImageDecoderConstructor = {
+  new (init: { data: ArrayBuffer | Uint8Array; type: string }): ImageDecoderLike;
+  isTypeSupported(type: string): Promise<boolean>;
+};
+
+function imageDecoderClass(): ImageDecoderConstructor | null {
+  return (globalThis as { ImageDecoder?: ImageDecoderConstructor }).ImageDecoder ?? null;
+}
+
+export function nativeDecodeAvailable(): boolean {
+  return typeof OffscreenCanvas !== 'undefined' && typeof createImageBitmap === 'function';
+}
+
+function find(data: Uint8Array, needle: number[], from: number): number {
+  let i = data.indexOf(needle[0], Math.max(0, from));
+  while (i !== -1 && i <= data.length - needle.length) {
+    if (startsWith(data, i, needle)) return i;
+    i = data.indexOf(needle[0], i + 1);
+  }
+  return -1;
+}
+
+function startsWith(data: Uint8Array, at: number, needle: number[]): boolean {
+  return needle.every((byte, j) => data[at + j] === byte);
+}
+
+/**
+ * Format 31: SOI..EOI slices (a missing EOI takes the rest), lazily and without a frame
+ * limit. Like Decoder0x1F the caller stops after ``totalFrames`` *decoded* frames, so a
+ * corrupt JPEG doesn't use up a slot.
+ */
+function* splitJpegs31(data: Uint8Array): Generator<Uint8Array> {
+  let pos = 0;
+  while (pos < data.length) {
+    const soi = find(data, SOI, pos);
+    if (soi === -1) return;
+    let eoi = find(data, EOI, soi + 2);
+    if (eoi === -1) eoi = data.length - 2;
+    yield data.subarray(soi, eoi + 2);
+    pos = eoi + 2;
+  }
+}
+
+/** Format 41: SOI..EOI slices with the optional 5-byte gap records skipped. */
+function splitJpegs41(data: Uint8Array, expectedFrames: number): Uint8Array[] {
+  const jpegs: Uint8Array[] = [];
+  let cursor = 0;
+  while (cursor < data.length) {
+    const start = find(data, SOI, cursor);
+    if (start === -1) break;
+    const end = find(data, EOI, start);
+    if (end === -1) break;
+    jpegs.push(data.subarray(start, end + 2));
+    cursor = end + 2;
+    if (cursor + 5 <= data.length && startsWith(data, cursor, GAP_PREFIX)) cursor += 5;
+    if (expectedFrames && jpegs.length >= expectedFrames) break;
+  }
+  return jpegs;
+}
+
+function makeCanvas(width: number, height: number) {
+  const canvas = new OffscreenCanvas(width, height);
+  const ctx = canvas.getContext('2d', { willReadFrequently: true });
+  if (!ctx) throw new Error('2D canvas unavailable');
+  ctx.imageSmoothingEnabled = false;
+  return { canvas, ctx };
+}
+
+function readRgb(ctx: OffscreenCanvasRenderingContext2D, width: number, height: number) {
+  const rgba = ctx.getImageData(0, 0, width, height).data;
+  const rgb = new Uint8Array(width * height * 3);
+  for (let src = 0, dst = 0; src < rgba.length; src += 4) {
+    rgb[dst++] = rgba[src];
+    rgb[dst++] = rgba[src + 1];
+    rgb[dst++] = rgba[src + 2];
+  }
+  return rgb;
+}
+
+/** Draw ``source`` onto a fresh ``width x height`` canvas (nearest-neighbour) as RGB. */
+function toRgb(source: CanvasImageSource, width: number, height: number): Uint8Array {
+  const { ctx } = makeCanvas(width, height);
+  ctx.drawImage(source, 0, 0, width, height);
+  return readRgb(ctx, width, height);
+}
+
+/** Decode JPEGs in order until ``limit`` succeed (or, with ``stopOnError``, one fails). */
+async function decodeJpegs(
+  jpegs: Iterable<Uint8Array>,
+  width: number,
+  height: number,
+  stopOnError: boolean,
+  limit = Infinity,
+): Promise<{ frames: Uint8Array[]; size: [number, number] }> {
+  const frames: Uint8Array[] = [];
+  let size: [number, number] = [width, height];
+  let i = -1;
+  for (const jpeg of jpegs) {
+    i++;
+    if (frames.length >= limit) break;
+    try {
+      const bitmap = await createImageBitmap(new Blob([jpeg.slice()], { type: 'image/jpeg' }));
+      if (!size[0] || !size[1]) size = [bitmap.width, bitmap.height]; // derive from frame 0
+      frames.push(toRgb(bitmap, size[0], size[1]));
+      bitmap.close();
+    } catch (error) {
+      logger.warn('embeddedImages: failed to decode JPEG frame', i, error);
+      if (stopOnError) break;
+    }
+  }
+  return { frames, size };
+}
+
+/** Composite every frame over white and over the previous result, like Pillow does. */
+async function decodeAnimation(payload: Uint8Array, type: string, width: number, height: number) {
+  const Decoder = imageDecoderClass();
+  if (!Decoder || !(await Decoder.isTypeSupported(type))) return null;
+  const decoder = new Decoder({ data: payload.slice(), type });
+  try {
+    await decoder.tracks.ready;
+    await decoder.completed;
+    const count = decoder.tracks.selectedTrack?.frameCount ?? 0;
+    let composed: ReturnType<typeof makeCanvas> | null = null;
+    const frames: Uint8Array[] = [];
+    for (let i = 0; i < count; i++) {
+      const { image } = await decoder.decode({ frameIndex: i });
+      if (!composed) {
+        composed = makeCanvas(image.displayWidth, image.displayHeight);
+        composed.ctx.fillStyle = '#ffffff';
+        composed.ctx.fillRect(0, 0, image.displayWidth, image.displayHeight);
+      }
+      composed.ctx.drawImage(image, 0, 0); // source-over == paste(rgba, mask=rgba)
+      image.close();
+      frames.push(toRgb(composed.canvas, width, height));
+    }
+    return frames;
+  } finally {
+    decoder.close();
+  }
+}
+
+function embeddedPayload(data: Uint8Array): { payload: Uint8Array; type: string } | null {
+  const gif = find(data, [0x47, 0x49, 0x46, 0x38], 0); // 'GIF8'
+  if (gif !== -1) return { payload: data.subarray(gif), type: 'image/gif' };
+  const riff = find(data, [0x52, 0x49, 0x46, 0x46], 0); // 'RIFF'
+  if (riff !== -1 && startsWith(data, riff + 8, [0x57, 0x45, 0x42, 0x50])) {
+    return { payload: data.subarray(riff), type: 'image/webp' };
+  }
+  return null; // Python lets Pillow sniff the container; leave that case to Pyodide
+}
+
+/** Decode a 31/41/43 file natively; ``null`` if the format or the browser isn't supported. */
+export async function decodeEmbeddedImages(raw: Uint8Array): Promise<NativeFrames | null> {
+  const format = raw[0];
+  if (!NATIVE_FORMATS.has(format) || raw.length < 6 || !nativeDecodeAvailable()) return null;
+  const totalFrames = raw[1];
+  const speed = (raw[2] << 8) | raw[3];
+  let rowCount = raw[4];
+  let columnCount = raw[5];
+
+  if (format === 43) {
+    const width = columnCount * 16;
+    const height = rowCount * 16;
+    const embedded = embeddedPayload(raw.subarray(6));
+    if (!embedded) return null;
+    const frames = await decodeAnimation(embedded.payload, embedded.type, width, height);
+    if (!frames) return null; // no ImageDecoder for this type: let Pillow do it
+    return { totalFrames: frames.length, speed, rowCount, columnCount, frames };
+  }
+
+  if (format === 31) {
+    const width = columnCount * 16;
+    const height = rowCount * 16;
+    const jpegs = splitJpegs31(raw.subarray(6));
+    let { frames } = await decodeJpegs(jpegs, width, height, false, totalFrames);
+    if (frames.length === 0) {
+      logger.warn('embeddedImages: format 31 without JPEG frames, using blank frames');
+      frames = Array.from({ length: totalFrames }, () => new Uint8Array(width * height * 3));
+    }
+    return { totalFrames: frames.length, speed, rowCount, columnCount, frames };
+  }
+
+  // Format 41
+  rowCount = rowCount || 1;
+  columnCount = columnCount || 1;
+  const jpegs = splitJpegs41(raw.subarray(6 + FORMAT_41_RESERVED), totalFrames);
+  const { frames } = await decodeJpegs(jpegs, columnCount * 16, rowCount * 16, true);
+  if (frames.length === 0) return null;
+  return { totalFrames: frames.length, speed: speed || 50, rowCount, columnCount, frames };
+}
+
+// -- worker client ------------------------------------------------------------------
+
+interface WorkerReply {
+  id: number;
+  result?: NativeFrames | null;
+  error?: string;
+}
+
+let worker: Worker | null = null;
+let workerFailed = false;
+let nextId = 1;
+const pending = new Map<number, (reply: WorkerReply) => void>();
+
+/** A dead worker answers nothing: fail its requests (they fall back) and stop using it. */
+function failWorker(reason: string): void {
+  logger.warn('embeddedImages: worker failed, decoding on the main thread', reason);
+  worker?.terminate();
+  worker = null;
+  workerFailed = true;
+  for (const [id, resolve] of pending) resolve({ id, error: reason });
+  pending.clear();
+}
+
+function getWorker(): Worker | null {
+  if (worker || workerFailed) return worker;
+  try {
+    worker = new Worker(new URL('./embeddedImageWorker.ts', import.meta.url), { type: 'module' });
+    worker.onmessage = (event: MessageEvent<WorkerReply>) => {
+      pending.get(event.data.id)?.(event.data);
+      pending.delete(event.data.id);
+    };
+    worker.onerror = (event) => failWorker(event.message || 'worker error');
+    worker.onmessageerror = () => failWorker('unreadable worker message');
+  } catch (error) {
+    logger.warn('embeddedImages: worker unavailable, decoding on the main thread', error);
+    workerFailed = true;
+  }
+  return worker;
+}
+
+/** {@link decodeEmbeddedImages} in a worker (main thread if workers are unavailable). */
+export async function decodeEmbeddedImagesOffThread(raw: Uint8Array): Promise<NativeFrames | null> {
+  if (!NATIVE_FORMATS.has(raw[0])) return null;
+  const target = getWorker();
+  if (!target) return decodeEmbeddedImages(raw);
+  const id = nextId++;
+  const reply = await new Promise<WorkerReply>((resolve) => {
+    pending.set(id, resolve);
+    target.postMessage({ id, raw });
+  });
+  if (reply.error) {
+    logger.warn('embeddedImages: native decode failed, falling back to Pyodide', reply.error);
+    return null;
+  }
+  return reply.result ?? null;
+}
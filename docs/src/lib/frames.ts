@@ -0,0 +1,13 @@
+// Pixel helpers shared by the main thread and workers.
+
+export function rgbToImageData(frame: Uint8Array, width: number, height: number): ImageData {
+  const rgba = new Uint8ClampedArray(width * height * 4);
+  let src = 0;
+  for (let i = 0; i < rgba.length; i += 4) {
+    rgba[i] = frame[src++];
+    rgba[i + 1] = frame[src++];
+    rgba[i + 2] = frame[src++];
+    rgba[i + 3] = 255;
+  }
+  return new ImageData(rgba, width, height);
+}
@@ -0,0 +1,256 @@
+// Typed-array ports of the hot per-pixel loops in pixel_bean_decoder.py, installed into the
+// Pyodide copy through the servoom_codecs bridge (see register_kernels in the Python).
+// Interpreted Python inside WASM pays ~100x per pixel; these run JIT-compiled instead.
+// Both must stay bit-exact with the Python they replace, including the error cases.
+
+/** ``_decode_0x0c_frame``: one 0x0C quantized-palette frame to RGB. Throws like Python. */
+export function decode0x0cFrame(data: Uint8Array, numPixels = 4096): Uint8Array {
+  const length = data.length;
+  const out = new Uint8Array(numPixels * 3);
+  // Solid-color fast path: AA 0B 00 F4 01 0C 01 00 R G B
+  if (
+    length === 11 &&
+    data[0] === 0xaa && data[1] === 0x0b && data[2] === 0x00 && data[3] === 0xf4 &&
+    data[4] === 0x01 && data[5] === 0x0c && data[6] === 0x01 && data[7] === 0x00
+  ) {
+    for (let i = 0; i < out.length; i += 3) {
+      out[i] = data[8];
+      out[i + 1] = data[9];
+      out[i + 2] = data[10];
+    }
+    return out;
+  }
+  if (length < 8) throw new Error(`Frame data too short: ${length} bytes`);
+  if (data[5] !== 0x0c) {
+    throw new Error(`Expected 0x0C encryption, got 0x${data[5].toString(16).toUpperCase().padStart(2, '0')}`);
+  }
+
+  // Bits per index: position of the highest set bit of the colour count, minus one.
+  let colors = data[6];
+  let paletteBytes = colors * 3;
+  let bits = 0xff;
+  if (colors === 0) {
+    bits = 8;
+    paletteBytes = 768; // corrupted frame
+  } else {
+    for (let bit = 1; colors !== 0; bit++, colors >>= 1) {
+      if (colors & 1) bits = bits === 0xff ? bit - 1 : bit;
+    }
+  }
+
+  const pos = (paletteBytes + 8) & 0xffff;
+  if (pos >= length) return out; // every index is "transparent" -> black
+  for (let pixel = 0; pixel < numPixels; pixel++) {
+    const bitOffset = bits * (pixel & 0xffff);
+    const shift = bitOffset & 7;
+    const idx = pos + (bitOffset >>> 3);
+    const end = bits + shift;
+    let index: number;
+    if (end < 9) {
+      if (idx >= length) continue;
+      index = ((data[idx] << (8 - end)) & 0xff) >> (shift + 8 - end);
+    } else {
+      if (idx + 1 >= length) continue;
+      index = ((((data[idx + 1] << (16 - end)) & 0xff) >> (16 - end)) << (8 - shift)) | (data[idx] >> shift);
+    }
+    const colorPos = 8 + index * 3;
+    if (colorPos + 2 < length) {
+      const target = pixel * 3;
+      out[target] = data[colorPos];
+      out[target + 1] = data[colorPos + 1];
+      out[target + 2] = data[colorPos + 2];
+    }
+  }
+  return out;
+}
+
+function bitsForCount(count: number): number {
+  if (count <= 1) return 0;
+  let bits = 1;
+  while (1 << bits < count) bits++;
+  return bits;
+}
+
+class QuadtreeError extends Error {}
+
+/** State for one ``_Decoder0x1AFrame`` walk; ``null`` from decode() == Python raising. */
+class QuadtreeWalk {
+  private readonly values = new Int32Array(64 * 64);
+  private readonly out: Uint8Array;
+  private readonly paletteCount: number;
+  private readonly pixel: Uint8Array;
+  private readonly width: number;
+  private readonly height: number;
+  private readonly palette: Uint8Array;
+
+  constructor(pixel: Uint8Array, width: number, height: number, palette: Uint8Array) {
+    this.pixel = pixel;
+    this.width = width;
+    this.height = height;
+    this.palette = palette;
+    this.paletteCount = Math.floor(palette.length / 3);
+    this.out = new Uint8Array(width * height * 3);
+  }
+
+  decode(): Uint8Array | null {
+    try {
+      let off = this.fix64(0, 0, 0);
+      if (this.width === 128 && this.height === 128) {
+        off += this.fix64(off, 1, 0);
+        off += this.fix64(off, 0, 1);
+        this.fix64(off, 1, 1);
+      }
+      return this.out;
+    } catch (error) {
+      if (error instanceof QuadtreeError) return null;
+      throw error;
+    }
+  }
+
+  /** LSB-first bit stream; bytes past the end read as zero. Returns the next byte offset. */
+  private readIndices(start: number, count: number, bits: number): number {
+    const { pixel, values } = this;
+    if (bits === 0) {
+      values.fill(0, 0, count);
+      return start;
+    }
+    const mask = (1 << bits) - 1;
+    const length = pixel.length;
+    for (let i = 0, bitOffset = 0; i < count; i++, bitOffset += bits) {
+      const at = start + (bitOffset >>> 3);
+      const word =
+        (at < length ? pixel[at] : 0) |
+        (at + 1 < length ? pixel[at + 1] << 8 : 0) |
+        (at + 2 < length ? pixel[at + 2] << 16 : 0);
+      values[i] = (word >>> (bitOffset & 7)) & mask;
+    }
+    return start + ((count * bits + 7) >>> 3);
+  }
+
+  /** ``_paint``: scatter a node along its 8x8-block walk through ``lut`` into the palette. */
+  private paint(size: number, x0: number, y0: number, lut: number[] | null, fallback = 0) {
+    const { width, out, palette, paletteCount, values } = this;
+    const base = y0 * width + x0;
+    if ((base + (size - 1) * width + size - 1) * 3 >= out.length) {
+      throw new QuadtreeError('node does not fit the frame');
+    }
+    if (paletteCount === 0) throw new QuadtreeError('empty palette');
+    const blocks = size >> 3;
+    let k = 0;
+    for (let br = 0; br < blocks; br++) {
+      for (let bc = 0; bc < blocks; bc++) {
+        for (let row = 0; row < 8; row++) {
+          let dest = (base + (br * 8 + row) * width + bc * 8) * 3;
+          for (let col = 0; col < 8; col++, k++, dest += 3) {
+            let index = values[k];
+            if (lut !== null) index = index < lut.length ? lut[index] : fallback;
+            if (index >= paletteCount) index = 0;
+            const src = index * 3;
+            out[dest] = palette[src];
+            out[dest + 1] = palette[src + 1];
+            out[dest + 2] = palette[src + 2];
+          }
+        }
+      }
+    }
+  }
+
+  /** Bits of an ``n``-bit mask at ``ptr``, mapped through ``parent`` (or as-is). */
+  private masked(ptr: number, n: number, parent: number[] | null): number[] {
+    if (ptr + ((n + 7) >> 3) > this.pixel.length) throw new QuadtreeError('mask out of bounds');
+    const picked: number[] = [];
+    for (let i = 0; i < n; i++) {
+      if ((this.pixel[ptr + (i >> 3)] >> (i & 7)) & 1) {
+        if (parent === null) picked.push(i);
+        else if (i < parent.length) picked.push(parent[i]);
+      }
+    }
+    return picked;
+  }
+
+  private fix64(offset: number, xq: number, yq: number): number {
+    const { pixel } = this;
+    if (offset + 1 >= pixel.length) throw new QuadtreeError('fix_64 header out of bounds');
+    const ctrl = pixel[offset];
+    if (ctrl === 0) {
+      const end = this.readIndices(offset + 1, 64 * 64, bitsForCount(this.paletteCount));
+      this.paint(64, xq * 64, yq * 64, null);
+      return end - offset;
+    }
+    const n = pixel[offset + 1] || 0x100;
+    const maskBytes = (n + 7) >> 3;
+    const ptr = offset + 2 + maskBytes;
+    const selected = this.masked(offset + 2, n, null);
+    if (ctrl === 2) {
+      const end = this.readIndices(ptr, 64 * 64, bitsForCount(selected.length));
+      if (selected.length === 0) throw new QuadtreeError('empty selection'); // selected[0]
+      this.paint(64, xq * 64, yq * 64, selected, selected[0]);
+      return end - offset;
+    }
+    let consumed = 0;
+    for (let q = 0; q < 4; q++) {
+      consumed += this.fixInner(32, ptr + consumed, xq * 2 + (q & 1), yq * 2 + (q >> 1), selected);
+    }
+    return 2 + maskBytes + consumed;
+  }
+
+  /** ``_decode_fix_32`` / ``_decode_fix_16``. */
+  private fixInner(size: number, offset: number, xq: number, yq: number, parent: number[]): number {
+    const { pixel } = this;
+    if (size === 8) return this.fix8(offset, xq, yq, parent);
+    if (offset + 1 >= pixel.length) throw new QuadtreeError(`fix_${size} header out of bounds`);
+    const ctrl = pixel[offset];
+    if (ctrl === 0) {
+      const end = this.readIndices(offset + 1, size * size, bitsForCount(parent.length || 1));
+      this.paint(size, xq * size, yq * size, parent);
+      return end - offset;
+    }
+    const n = pixel[offset + 1] || 0x100;
+    const maskBytes = (n + 7) >> 3;
+    const ptr = offset + 2 + maskBytes;
+    let selected = this.masked(offset + 2, n, parent);
+    if (selected.length === 0) selected = [0];
+    if (ctrl === 2) {
+      const end = this.readIndices(ptr, size * size, bitsForCount(selected.length));
+      this.paint(size, xq * size, yq * size, selected);
+      return end - offset;
+    }
+    const child = size >> 1;
+    let consumed = 0;
+    for (let q = 0; q < 4; q++) {
+      consumed += this.fixInner(child, ptr + consumed, xq * 2 + (q & 1), yq * 2 + (q >> 1), selected);
+    }
+    return 2 + maskBytes + consumed;
+  }
+
+  private fix8(offset: number, xq: number, yq: number, parent: number[]): number {
+    const { pixel } = this;
+    if (offset >= pixel.length) throw new QuadtreeError('fix_8 header out of bounds');
+    const first = pixel[offset];
+    if (first & 0x80) {
+      const n = first & 0x7f;
+      let selected = this.masked(offset + 1, n, parent);
+      if (selected.length === 0) selected = [0];
+      const end = this.readIndices(offset + 1 + ((n + 7) >> 3), 64, bitsForCount(selected.length));
+      this.paint(8, xq * 8, yq * 8, selected);
+      return end - offset;
+    }
+    const end = this.readIndices(offset + 1, 64, bitsForCount(parent.length));
+    this.paint(8, xq * 8, yq * 8, parent);
+    return end - offset;
+  }
+}
+
+/**
+ * ``_Decoder0x1AFrame.decode_frame``: walk one quadtree (``pixel`` = the frame after its
+ * palette, ``palette`` = flat RGB) into a ``width x height`` RGB frame. ``null`` where the
+ * Python raises IndexError/ValueError.
+ */
+export function decode0x1aPixels(
+  pixel: Uint8Array,
+  width: number,
+  height: number,
+  palette: Uint8Array,
+): Uint8Array | null {
+  return new QuadtreeWalk(pixel, width, height, palette).decode();
+}
@@ -0,0 +1,190 @@
+// Animation preview engine: frames become ImageBitmaps once (in a worker), and every
+// preview on the page is driven by one shared requestAnimationFrame loop that only ticks
+// previews currently on screen (IntersectionObserver).
+import type { DecodedBean } from './pyodideDecoder';
+import type { PreviewWorkerRequest, PreviewWorkerResponse } from './previewWorker';
+import { rgbToImageData } from './frames';
+import logger from './logger';
+
+const DEFAULT_FRAME_MS = 40;
+
+let worker: Worker | null = null;
+let workerFailed = false;
+let nextRequestId = 1;
+const pendingRequests = new Map<
+  number,
+  { resolve: (bitmaps: ImageBitmap[]) => void; reject: (error: Error) => void }
+>();
+
+/** A dead worker answers nothing: reject its requests (they retry here) and stop using it. */
+function failWorker(reason: string): void {
+  worker?.terminate();
+  worker = null;
+  workerFailed = true;
+  const error = new Error(reason);
+  for (const pending of pendingRequests.values()) pending.reject(error);
+  pendingRequests.clear();
+}
+
+function getWorker(): Worker | null {
+  if (worker || workerFailed) return worker;
+  try {
+    worker = new Worker(new URL('./previewWorker.ts', import.meta.url), { type: 'module' });
+    worker.onmessage = (event: MessageEvent<PreviewWorkerResponse>) => {
+      const pending = pendingRequests.get(event.data.id);
+      if (!pending) return;
+      pendingRequests.delete(event.data.id);
+      if ('error' in event.data) {
+        pending.reject(new Error(event.data.error));
+      } else {
+        pending.resolve(event.data.bitmaps);
+      }
+    };
+    worker.onerror = (event) => failWorker(event.message || 'worker error');
+    worker.onmessageerror = () => failWorker('unreadable worker message');
+  } catch (error) {
+    logger.warn('previewEngine: worker unavailable, converting on the main thread', error);
+    workerFailed = true;
+  }
+  return worker;
+}
+
+async function convertOnMainThread(bean: DecodedBean, width: number, height: number) {
+  const bitmaps: ImageBitmap[] = [];
+  for (const frame of bean.frames) {
+    bitmaps.push(await createImageBitmap(rgbToImageData(frame, width, height)));
+  }
+  return bitmaps;
+}
+
+function convertFrames(bean: DecodedBean, width: number, height: number): Promise<ImageBitmap[]> {
+  const target = getWorker();
+  if (!target) return convertOnMainThread(bean, width, height);
+  const id = nextRequestId++;
+  const request: PreviewWorkerRequest = { id, width, height, frames: bean.frames };
+  return new Promise<ImageBitmap[]>((resolve, reject) => {
+    pendingRequests.set(id, { resolve, reject });
+    target.postMessage(request); // frames are copied; the bean keeps its own
+  }).catch((error) => {
+    logger.warn('previewEngine: worker conversion failed, retrying on the main thread', error);
+    return convertOnMainThread(bean, width, height);
+  });
+}
+
+// Bitmaps are shared by every preview of the same bean and closed with the last one.
+const bitmapCache = new Map<DecodedBean, { bitmaps: Promise<ImageBitmap[]>; refs: number }>();
+
+export function acquireBitmaps(bean: DecodedBean): Promise<ImageBitmap[]> {
+  let entry = bitmapCache.get(bean);
+  if (!entry) {
+    const width = bean.columnCount * 16;
+    const height = bean.rowCount * 16;
+    entry = { bitmaps: convertFrames(bean, width, height), refs: 0 };
+    bitmapCache.set(bean, entry);
+  }
+  entry.refs += 1;
+  return entry.bitmaps;
+}
+
+export function releaseBitmaps(bean: DecodedBean): void {
+  const entry = bitmapCache.get(bean);
+  if (!entry) return;
+  entry.refs -= 1;
+  if (entry.refs > 0) return;
+  bitmapCache.delete(bean);
+  entry.bitmaps.then((bitmaps) => bitmaps.forEach((bitmap) => bitmap.close())).catch(() => {});
+}
+
+interface Player {
+  ctx: CanvasRenderingContext2D;
+  bitmaps: ImageBitmap[];
+  frameMs: number;
+  frameIndex: number;
+  elapsed: number;
+  visible: boolean;
+  dirty: boolean;
+}
+
+const players = new Map<HTMLCanvasElement, Player>();
+let rafId: number | null = null;
+let lastTick = 0;
+
+function draw(player: Player) {
+  const { ctx } = player;
+  ctx.clearRect(0, 0, ctx.canvas.width, ctx.canvas.height);
+  ctx.drawImage(player.bitmaps[player.frameIndex], 0, 0, ctx.canvas.width, ctx.canvas.height);
+  player.dirty = false;
+}
+
+function tick(now: number) {
+  const dt = lastTick ? now - lastTick : 0;
+  lastTick = now;
+  let active = 0;
+  players.forEach((player) => {
+    if (!player.visible) return;
+    active += 1;
+    if (player.bitmaps.length > 1) {
+      // Accumulate real elapsed time so playback speed doesn't depend on the display's
+      // refresh rate; after a long stall, skip ahead instead of fast-forwarding.
+      player.elapsed += dt;
+      const loop = player.frameMs * player.bitmaps.length;
+      if (player.elapsed >= loop) player.elapsed %= loop;
+      while (player.elapsed >= player.frameMs) {
+        player.elapsed -= player.frameMs;
+        player.frameIndex = (player.frameIndex + 1) % player.bitmaps.length;
+        player.dirty = true;
+      }
+    }
+    if (player.dirty) draw(player);
+  });
+  rafId = active > 0 ? requestAnimationFrame(tick) : null;
+  if (rafId === null) lastTick = 0;
+}
+
+function ensureLoop() {
+  if (rafId === null) rafId = requestAnimationFrame(tick);
+}
+
+let observer: IntersectionObserver | null = null;
+
+function getObserver(): IntersectionObserver | null {
+  if (observer || typeof IntersectionObserver === 'undefined') return observer;
+  observer = new IntersectionObserver((entries) => {
+    entries.forEach((entry) => {
+      const player = players.get(entry.target as HTMLCanvasElement);
+      if (!player) return;
+      player.visible = entry.isIntersecting;
+      if (player.visible) ensureLoop();
+    });
+  });
+  return observer;
+}
+
+/** Play ``bitmaps`` on ``canvas`` (already sized); returns a function that stops it. */
+export function startPlayback(
+  canvas: HTMLCanvasElement,
+  bitmaps: ImageBitmap[],
+  speed: number,
+): () => void {
+  const ctx = canvas.getContext('2d');
+  if (!ctx || bitmaps.length === 0) return () => {};
+  ctx.imageSmoothingEnabled = false;
+  const io = getObserver();
+  const player: Player = {
+    ctx,
+    bitmaps,
+    frameMs: speed || DEFAULT_FRAME_MS,
+    frameIndex: 0,
+    elapsed: 0,
+    visible: io === null, // without IntersectionObserver, always play
+    dirty: true,
+  };
+  players.set(canvas, player);
+  draw(player); // first frame right away, even offscreen
+  if (io) io.observe(canvas);
+  ensureLoop();
+  return () => {
+    players.delete(canvas);
+    io?.unobserve(canvas);
+  };
+}
@@ -0,0 +1,35 @@
+// Converts decoded RGB frames into ImageBitmaps off the main thread (see previewEngine.ts).
+import { rgbToImageData } from './frames';
+
+export interface PreviewWorkerRequest {
+  id: number;
+  width: number;
+  height: number;
+  frames: Uint8Array[];
+}
+
+export type PreviewWorkerResponse =
+  | { id: number; bitmaps: ImageBitmap[] }
+  | { id: number; error: string };
+
+// The app compiles against the DOM lib only; this is the slice of the worker scope used here.
+const scope = self as unknown as {
+  onmessage: ((event: MessageEvent<PreviewWorkerRequest>) => void) | null;
+  postMessage(message: PreviewWorkerResponse, transfer?: Transferable[]): void;
+};
+
+scope.onmessage = async (event: MessageEvent<PreviewWorkerRequest>) => {
+  const { id, width, height, frames } = event.data;
+  try {
+    // One ImageData at a time: only the finished bitmaps stay alive.
+    const bitmaps: ImageBitmap[] = [];
+    for (const frame of frames) {
+      bitmaps.push(await createImageBitmap(rgbToImageData(frame, width, height)));
+    }
+    const response: PreviewWorkerResponse = { id, bitmaps };
+    scope.postMessage(response, bitmaps);
+  } catch (error) {
+    const response: PreviewWorkerResponse = { id, error: String(error) };
+    scope.postMessage(response);
+  }
+};
@@ -1,11 +1,13 @@
 import type { PyodideInterface } from 'pyodide';
-import { loadPyodide } from 'pyodide';
 import type { PyProxy } from 'pyodide/ffi';
 import pixelBeanSource from '../python/pixel_bean.py?raw';
 import pixelDecoderSource from '../python/pixel_bean_decoder.py?raw';
 import { ensureLzoReady, lzoDecompressSync } from './lzo';
 import { ensureZstdReady, zstdDecompressSync } from './zstd';
 import { decryptAesCbcSync } from './crypto';
+import { decodeEmbeddedImagesOffThread } from './embeddedImages';
+import { decode0x0cFrame, decode0x1aPixels } from './pixelKernels';
+import { loadRuntime, whenIdle } from './pyodideRuntime';
 import logger from './logger';
 
 export interface DecodedBean {
@@ -14,8 +16,9 @@ export interface DecodedBean {
   rowCount: number;
   columnCount: number;
   frames: Uint8Array[];
-  webp: Uint8Array;
-  gif: Uint8Array;
+  // Filled by the Pyodide decode; natively decoded beans get them from exports() on demand.
+  webp?: Uint8Array;
+  gif?: Uint8Array;
 }
 
 const STUB_MODULES = `
@@ -75,7 +78,36 @@ sys.modules["Crypto.Cipher.AES"] = aescipher_module
 
 const BRIDGE_MODULE = `
 from io import BytesIO
-from pixel_bean_decoder import PixelBeanDecoder
+from js import Uint8Array
+import servoom_codecs
+from pixel_bean_decoder import PixelBeanDecoder, register_kernels
+
+def _decode_0x0c_frame(data, num_pixels=4096):
+    out = servoom_codecs.decode_0x0c_frame(Uint8Array.new(bytes(data)), int(num_pixels))
+    return bytes(out.to_py())
+
+def _decode_0x1a_pixels(pixel, width, height, palette):
+    out = servoom_codecs.decode_0x1a_pixels(
+        Uint8Array.new(bytes(pixel)), int(width), int(height), Uint8Array.new(palette))
+    return None if out is None else bytes(out.to_py())
+
+register_kernels(decode_0x0c_frame=_decode_0x0c_frame, decode_0x1a_pixels=_decode_0x1a_pixels)
+
+def _exports(bean):
+    webp_buffer = BytesIO()
+    bean.save_to_webp(webp_buffer)
+    gif_buffer = BytesIO()
+    bean.save_to_gif(gif_buffer)
+    return {"webp": webp_buffer.getvalue(), "gif": gif_buffer.getvalue()}
+
+def encode_frames(frames, speed: int, row_count: int, column_count: int):
+    import numpy as np
+    from pixel_bean import PixelBean
+    height, width = row_count * 16, column_count * 16
+    arrays = [np.frombuffer(bytes(f), dtype=np.uint8).reshape(height, width, 3) for f in frames]
+    bean = PixelBean(metadata={}, total_frames=len(arrays), speed=speed,
+                     row_count=row_count, column_count=column_count, frames_data=arrays)
+    return _exports(bean)
 
 def decode_pixel_bean(raw_bytes: bytes):
     bean = PixelBeanDecoder.decode_stream(BytesIO(raw_bytes))
@@ -120,6 +152,13 @@ function registerCodecBridge(pyodide: PyodideInterface): void {
     aes_decrypt(payload: Uint8Array, key: Uint8Array, iv: Uint8Array) {
       return decryptAesCbcSync(copyBuffer(payload), copyBuffer(key), copyBuffer(iv));
     },
+    // Pixel kernels read their input synchronously, so no defensive copies.
+    decode_0x0c_frame(data: Uint8Array, numPixels: number) {
+      return decode0x0cFrame(data, numPixels);
+    },
+    decode_0x1a_pixels(pixel: Uint8Array, width: number, height: number, palette: Uint8Array) {
+      return decode0x1aPixels(pixel, width, height, palette);
+    },
   };
   pyodide.registerJsModule('servoom_codecs', bridge);
 }
@@ -128,6 +167,7 @@ export class PyodideDecoder {
   private pyodide: PyodideInterface | null = null;
   private readyPromise: Promise<void> | null = null;
   private decodeProxy: PyProxy | null = null;
+  private encodeProxy: PyProxy | null = null;
 
   async ensureReady(): Promise<void> {
     if (!this.pyodide) {
@@ -138,15 +178,23 @@ export class PyodideDecoder {
     }
   }
 
-  private async initialize(): Promise<void> {
-    logger.info('PyodideDecoder: preparing native bridges');
-    await Promise.all([ensureLzoReady(), ensureZstdReady()]);
-    logger.info('PyodideDecoder: loading Pyodide');
-    this.pyodide = await loadPyodide({
-      indexURL: 'https://cdn.jsdelivr.net/pyodide/v0.29.0/full/',
+  /** Start the decoder once the page is idle instead of on the first decode; returns a canceller. */
+  warmUp(): () => void {
+    return whenIdle(() => {
+      this.ensureReady().catch((error) => logger.warn('PyodideDecoder: warm-up failed', error));
     });
+  }
+
+  private async initialize(): Promise<void> {
+    const started = performance.now();
+    logger.info('PyodideDecoder: loading Pyodide and native bridges');
+    const [pyodide] = await Promise.all([
+      loadRuntime(),
+      ensureLzoReady(),
+      ensureZstdReady(),
+    ]);
+    this.pyodide = pyodide;
     registerCodecBridge(this.pyodide);
-    await this.pyodide.loadPackage(['numpy', 'pillow']);
     try {
       this.pyodide.FS.mkdir('/servoom');
     } catch {
@@ -160,12 +208,29 @@ import sys
 sys.path.append('/servoom')
 `);
     await this.pyodide.runPythonAsync(STUB_MODULES);
-    await this.pyodide.runPythonAsync('from servoom_bridge import decode_pixel_bean');
+    await this.pyodide.runPythonAsync('from servoom_bridge import decode_pixel_bean, encode_frames');
     this.decodeProxy = this.pyodide.globals.get('decode_pixel_bean');
-    logger.info('PyodideDecoder: initialization complete');
+    this.encodeProxy = this.pyodide.globals.get('encode_frames');
+    logger.info('PyodideDecoder: initialization complete', {
+      ms: Math.round(performance.now() - started),
+    });
   }
 
   async decode(data: Uint8Array): Promise<DecodedBean> {
+    // JPEG/GIF/WebP-bearing formats (31/41/43) decode with the browser's codecs in a
+    // worker, without waiting for Pyodide; everything else (and any failure) uses Python.
+    const native = await decodeEmbeddedImagesOffThread(data).catch((error) => {
+      logger.warn('PyodideDecoder: native decode failed, using Pyodide', error);
+      return null;
+    });
+    if (native) {
+      logger.info('PyodideDecoder: decoded natively', {
+        format: data[0],
+        frames: native.frames.length,
+        dimensions: `${native.columnCount * 16}x${native.rowCount * 16}`,
+      });
+      return { ...native };
+    }
     await this.ensureReady();
     if (!this.pyodide || !this.decodeProxy) {
       throw new Error('Pyodide decoder unavailable');
@@ -206,4 +271,28 @@ sys.path.append('/servoom')
       pyBytes.destroy();
     }
   }
+
+  /** WebP and GIF exports of ``bean``, encoded with Pillow the first time they're needed. */
+  async exports(bean: DecodedBean): Promise<{ webp: Uint8Array; gif: Uint8Array }> {
+    if (bean.webp && bean.gif) return { webp: bean.webp, gif: bean.gif };
+    await this.ensureReady();
+    if (!this.pyodide || !this.encodeProxy) {
+      throw new Error('Pyodide decoder unavailable');
+    }
+    const pyFrames = this.pyodide.toPy(bean.frames);
+    try {
+      const callable = this.encodeProxy as unknown as (...args: unknown[]) => PyProxy;
+      const result = callable(pyFrames, bean.speed, bean.rowCount, bean.columnCount);
+      const jsResult = result.toJs({ dict_converter: Object.fromEntries, create_pyproxies: false }) as {
+        webp: Uint8Array<ArrayBufferLike>;
+        gif: Uint8Array<ArrayBufferLike>;
+      };
+      result.destroy();
+      bean.webp = toPlainUint8Array(jsResult.webp);
+      bean.gif = toPlainUint8Array(jsResult.gif);
+      return { webp: bean.webp, gif: bean.gif };
+    } finally {
+      pyFrames.destroy();
+    }
+  }
 }
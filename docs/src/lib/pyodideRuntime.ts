@@ -0,0 +1,39 @@
+// Pyodide startup: versioned CDN location, cached runtime, idle scheduling.
+//
+// The runtime files and the numpy/Pillow wheels are pinned to PYODIDE_VERSION, so the
+// service worker (public/sw.js) can serve them cache-first after the first visit. The
+// decoder boots when the page goes idle (see PyodideDecoder.warmUp), so a warm start
+// costs no network and, usually, no wait.
+import type { PyodideInterface } from 'pyodide';
+import { loadPyodide } from 'pyodide';
+import logger from './logger';
+
+export const PYODIDE_VERSION = '0.29.0';
+export const PYODIDE_INDEX_URL = `https://cdn.jsdelivr.net/pyodide/v${PYODIDE_VERSION}/full/`;
+export const PYODIDE_PACKAGES = ['numpy', 'pillow'];
+
+/** Boot Pyodide with the decoder's packages. */
+export function loadRuntime(): Promise<PyodideInterface> {
+  return loadPyodide({ indexURL: PYODIDE_INDEX_URL, packages: PYODIDE_PACKAGES });
+}
+
+/** Run ``task`` when the page is idle (or after ``timeout`` ms); returns a canceller. */
+export function whenIdle(task: () => void, timeout = 2000): () => void {
+  if (typeof requestIdleCallback === 'function') {
+    const handle = requestIdleCallback(task, { timeout });
+    return () => cancelIdleCallback(handle);
+  }
+  const handle = setTimeout(task, 200);
+  return () => clearTimeout(handle);
+}
+
+/** Register public/sw.js, which caches the versioned Pyodide runtime and wheels. */
+export function registerRuntimeCache(): void {
+  if (!import.meta.env.PROD || typeof navigator === 'undefined' || !('serviceWorker' in navigator)) {
+    return;
+  }
+  const base = import.meta.env.BASE_URL;
+  navigator.serviceWorker
+    .register(`${base}sw.js?pyodide=${encodeURIComponent(PYODIDE_INDEX_URL)}`, { scope: base })
+    .catch((error) => logger.warn('pyodideRuntime: service worker registration failed', error));
+}
@@ -0,0 +1,102 @@
+// Shared network scheduler: at most `concurrency` requests in flight, dispatched by lane
+// priority so a preview the user is waiting for never queues behind a 500-file ZIP export.
+// Every task gets an AbortSignal; aborting drops it from the queue or cancels its fetch.
+
+export type Lane = 'preview' | 'listing' | 'bulk';
+
+// Highest priority first
+const LANES: Lane[] = ['preview', 'listing', 'bulk'];
+const DEFAULT_CONCURRENCY = 6; // browsers allow ~6 connections per host over HTTP/1.1
+
+interface Job {
+  run: () => void;
+}
+
+function abortReason(signal: AbortSignal): unknown {
+  return signal.reason ?? new DOMException('Aborted', 'AbortError');
+}
+
+export class RequestScheduler {
+  private readonly queues = new Map<Lane, Job[]>(LANES.map((lane) => [lane, []]));
+  private active = 0;
+  private readonly concurrency: number;
+
+  constructor(concurrency = DEFAULT_CONCURRENCY) {
+    this.concurrency = Math.max(1, concurrency);
+  }
+
+  /** Run ``task`` when a slot is free; rejects with the abort reason if ``signal`` fires first. */
+  schedule<T>(lane: Lane, task: (signal?: AbortSignal) => Promise<T>, signal?: AbortSignal): Promise<T> {
+    if (signal?.aborted) return Promise.reject(abortReason(signal));
+    return new Promise<T>((resolve, reject) => {
+      const queue = this.queues.get(lane)!;
+      const onAbort = () => {
+        const index = queue.indexOf(job);
+        if (index === -1) return; // already running: the task's own fetch sees the signal
+        queue.splice(index, 1);
+        reject(abortReason(signal!));
+      };
+      const job: Job = {
+        run: () => {
+          signal?.removeEventListener('abort', onAbort);
+          this.active += 1;
+          Promise.resolve()
+            .then(() => task(signal))
+            .then(resolve, reject)
+            .finally(() => {
+              this.active -= 1;
+              this.pump();
+            });
+        },
+      };
+      signal?.addEventListener('abort', onAbort, { once: true });
+      queue.push(job);
+      this.pump();
+    });
+  }
+
+  private pump(): void {
+    while (this.active < this.concurrency) {
+      const job = this.nextJob();
+      if (!job) return;
+      job.run();
+    }
+  }
+
+  private nextJob(): Job | undefined {
+    for (const lane of LANES) {
+      const job = this.queues.get(lane)!.shift();
+      if (job) return job;
+    }
+    return undefined;
+  }
+}
+
+export const requestScheduler = new RequestScheduler();
+
+/**
+ * Run ``task`` over ``items`` with at most ``window`` outstanding and yield the results in
+ * input order. Tasks do their own scheduling (usually through ``requestScheduler``), so
+ * the window bounds memory and lookahead while the scheduler bounds the network.
+ */
+export async function* inOrder<T, R>(
+  items: readonly T[],
+  task: (item: T) => Promise<R>,
+  window = DEFAULT_CONCURRENCY * 2,
+): AsyncGenerator<R> {
+  const pending: Promise<R>[] = [];
+  let next = 0;
+  const fill = () => {
+    while (next < items.length && pending.length < Math.max(1, window)) {
+      const promise = task(items[next++]);
+      promise.catch(() => {}); // surfaced when its turn comes; no unhandled rejections
+      pending.push(promise);
+    }
+  };
+  fill();
+  while (pending.length) {
+    const result = await pending.shift()!;
+    fill();
+    yield result;
+  }
+}
@@ -5,14 +5,14 @@ constructing a :class:`DivoomClient` resolves credentials.
 """
 
 from .pixel_bean import PixelBean, PixelBeanState
-from .pixel_bean_decoder import PixelBeanDecoder
+from .pixel_bean_decoder import DecoderContext, FrameSeekIndex, PixelBeanDecoder
 from .layer_file_decoder import LayerFileDecoder, LayerBean
 from .client import DivoomClient
 from .config import Settings, DEFAULT_SETTINGS
 from .credentials import load_credentials, Credentials, CredentialsError
 
 __all__ = [
-    "PixelBean", "PixelBeanState", "PixelBeanDecoder",
+    "PixelBean", "PixelBeanState", "PixelBeanDecoder", "FrameSeekIndex", "DecoderContext",
     "LayerFileDecoder", "LayerBean", "DivoomClient",
     "Settings", "DEFAULT_SETTINGS",
     "load_credentials", "Credentials", "CredentialsError",
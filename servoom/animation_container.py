@@ -0,0 +1,202 @@
+"""Compact lossless container for decoded animations (``.svan``).
+
+Lossless WebP is slow to encode and slow to turn back into numpy. This container is built
+for analysis jobs that re-read decoded frames. It stays small for pixel art, and decoding
+is a zstd call plus a few numpy passes per frame group. Layout (big-endian)::
+
+    header   magic 'SVAN', version u8, flags u8, width u16, height u16, frames u32,
+             speed u16, row_count u8, column_count u8, group_size u16, groups u32
+    index    per group: offset u64, compressed length u32, raw length u32
+    groups   zstd( palette_len u32, palette_len*3 bytes, then per frame:
+                   kind u8  0 = key (full frame), 1 = delta, 2 = same as previous
+                   delta: x u16, y u16, w u16, h u16, XOR of that rect vs previous )
+
+Each group of ``group_size`` frames is compressed on its own and starts with a key
+frame, so frame ``k`` needs only its own group (:meth:`ContainerReader.frame`). A group
+with a palette (``palette_len`` > 0) stores palette indices instead of RGB triplets:
+uint8 for up to 256 colours, little-endian uint16 for up to 65536. Deltas XOR only the
+bounding rectangle of changed pixels, in whichever space the group uses. Unchanged pixels
+become zeros, which zstd compresses to almost nothing.
+
+For pixel art (at most 256 colours) files come out well under lossless WebP. Photographic
+uploads with tens of thousands of colours land somewhat above it. Either way, a group
+decodes in a few milliseconds straight into numpy.
+"""
+
+from __future__ import annotations
+
+import struct
+from pathlib import Path
+from typing import BinaryIO, List, Union
+
+import numpy as np
+
+from .pixel_bean import PixelBean
+
+MAGIC = b'SVAN'
+VERSION = 1
+_HEADER = struct.Struct('>4sBBHHIHBBHI')
+_GROUP = struct.Struct('>QII')
+_PALETTE_LEN = struct.Struct('>I')
+_RECT = struct.Struct('>HHHH')
+_KEY, _DELTA, _SAME = range(3)
+
+
+def _group_palette(frames: List[np.ndarray]):
+    """``(palette (N, 3), index frames)`` if the group has <= 65536 colours, else ``None``.
+
+    Indices are uint8 for up to 256 colours, else little-endian uint16.
+    """
+    packed = [(f[..., 0].astype(np.uint32) << 16) | (f[..., 1].astype(np.uint32) << 8) | f[..., 2]
+              for f in frames]
+    colours = np.unique(np.concatenate([p.ravel() for p in packed]))
+    if len(colours) > 65536:
+        return None
+    palette = np.stack([(colours >> 16) & 0xFF, (colours >> 8) & 0xFF, colours & 0xFF],
+                       axis=1).astype(np.uint8)
+    dtype = np.uint8 if len(colours) <= 256 else np.dtype('<u2')
+    return palette, [np.searchsorted(colours, p).astype(dtype) for p in packed]
+
+
+def _encode_group(frames: List[np.ndarray]) -> bytes:
+    indexed = _group_palette(frames)
+    if indexed is None:
+        palette, planes = np.zeros((0, 3), np.uint8), frames
+    else:
+        palette, planes = indexed
+    out = [_PALETTE_LEN.pack(len(palette)), palette.tobytes()]
+    previous = None
+    for plane in planes:
+        if previous is None:
+            out += [bytes([_KEY]), np.ascontiguousarray(plane).tobytes()]
+        else:
+            changed = plane != previous
+            if changed.ndim == 3:
+                changed = changed.any(axis=2)
+            rows, cols = np.flatnonzero(changed.any(axis=1)), np.flatnonzero(changed.any(axis=0))
+            if not len(rows):
+                out.append(bytes([_SAME]))
+            else:
+                y, x = int(rows[0]), int(cols[0])
+                h, w = int(rows[-1]) - y + 1, int(cols[-1]) - x + 1
+                xor = np.bitwise_xor(plane[y:y + h, x:x + w], previous[y:y + h, x:x + w])
+                out += [bytes([_DELTA]), _RECT.pack(x, y, w, h), xor.tobytes()]
+        previous = plane
+    return b''.join(out)
+
+
+def write_container(bean: PixelBean, output: Union[str, Path, BinaryIO], group_size: int = 32,
+                    level: int = 9) -> int:
+    """Write ``bean``'s frames as a ``.svan`` container; returns the bytes written."""
+    import zstandard
+
+    frames = [np.asarray(f, dtype=np.uint8) for f in bean.frames_data]
+    height, width = frames[0].shape[:2] if frames else (bean.height or 0, bean.width or 0)
+    groups = [frames[i:i + group_size] for i in range(0, len(frames), group_size)]
+    compressor = zstandard.ZstdCompressor(level=level)
+    raw = [_encode_group(g) for g in groups]
+    blobs = [compressor.compress(r) for r in raw]
+
+    offset = _HEADER.size + _GROUP.size * len(blobs)
+    table = []
+    for blob, plain in zip(blobs, raw):
+        table.append(_GROUP.pack(offset, len(blob), len(plain)))
+        offset += len(blob)
+    data = b''.join([
+        _HEADER.pack(MAGIC, VERSION, 0, width, height, len(frames), bean.speed or 0,
+                     bean.row_count or 0, bean.column_count or 0, group_size, len(blobs)),
+        *table, *blobs,
+    ])
+    if hasattr(output, 'write'):
+        output.write(data)
+    else:
+        Path(output).write_bytes(data)
+    return len(data)
+
+
+class ContainerReader:
+    """Random-access reader over a ``.svan`` file (path) or its bytes."""
+
+    def __init__(self, source: Union[str, Path, bytes, memoryview]):
+        if isinstance(source, (str, Path)):
+            source = Path(source).read_bytes()
+        self._data = memoryview(source)
+        (magic, version, _flags, self.width, self.height, self.total_frames, self.speed,
+         self.row_count, self.column_count, self.group_size, groups) = \
+            _HEADER.unpack_from(self._data, 0)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError('Not a servoom animation container (or unsupported version)')
+        self._groups = [_GROUP.unpack_from(self._data, _HEADER.size + i * _GROUP.size)
+                        for i in range(groups)]
+        self._cache = (None, None)  # (group number, decoded frames)
+
+    def __len__(self) -> int:
+        return self.total_frames
+
+    def _decode_group(self, g: int) -> List[np.ndarray]:
+        import zstandard
+
+        if self._cache[0] == g:
+            return self._cache[1]
+        offset, length, raw_length = self._groups[g]
+        raw = zstandard.ZstdDecompressor().decompress(self._data[offset:offset + length],
+                                                      max_output_size=raw_length)
+        n_pal = _PALETTE_LEN.unpack_from(raw, 0)[0]
+        pos = _PALETTE_LEN.size
+        palette = np.frombuffer(raw, np.uint8, n_pal * 3, pos).reshape(-1, 3)
+        pos += n_pal * 3
+        if n_pal:
+            dtype, shape = np.dtype(np.uint8 if n_pal <= 256 else '<u2'), (self.height, self.width)
+        else:
+            dtype, shape = np.dtype(np.uint8), (self.height, self.width, 3)
+        count = min(self.group_size, self.total_frames - g * self.group_size)
+        planes, previous = [], None
+        for _ in range(count):
+            kind = raw[pos]
+            pos += 1
+            if kind == _KEY:
+                size = int(np.prod(shape))
+                plane = np.frombuffer(raw, dtype, size, pos).reshape(shape)
+                pos += size * dtype.itemsize
+            elif kind == _SAME:
+                plane = previous
+            else:
+                x, y, w, h = _RECT.unpack_from(raw, pos)
+                pos += _RECT.size
+                rect = (h, w) + shape[2:]
+                size = int(np.prod(rect))
+                plane = previous.copy()
+                plane[y:y + h, x:x + w] ^= np.frombuffer(raw, dtype, size, pos).reshape(rect)
+                pos += size * dtype.itemsize
+            planes.append(plane)
+            previous = plane
+        frames = [palette[p] for p in planes] if n_pal else [p.copy() for p in planes]
+        self._cache = (g, frames)
+        return frames
+
+    def frame(self, k: int) -> np.ndarray:
+        """Frame ``k`` (0-based) as an ``(H, W, 3)`` uint8 array, decoding only its group."""
+        if not 0 <= k < self.total_frames:
+            raise IndexError(f'Frame {k} out of range (0..{self.total_frames - 1})')
+        return self._decode_group(k // self.group_size)[k % self.group_size]
+
+    def frames(self) -> List[np.ndarray]:
+        out = []
+        for g in range(len(self._groups)):
+            out.extend(self._decode_group(g))
+        return out
+
+    def to_pixel_bean(self) -> PixelBean:
+        return PixelBean(
+            metadata={},
+            total_frames=self.total_frames,
+            speed=self.speed,
+            row_count=self.row_count,
+            column_count=self.column_count,
+            frames_data=self.frames(),
+        )
+
+
+def read_container(source: Union[str, Path, bytes]) -> PixelBean:
+    """Read a whole ``.svan`` container back into a :class:`PixelBean`."""
+    return ContainerReader(source).to_pixel_bean()
@@ -1,10 +1,13 @@
 """Command-line interface: ``python -m servoom <command>``.
 
 Commands:
-  decode        decode a pixel .dat (or a folder of them) to WebP/GIF
+  decode        decode a pixel .dat (or a folder of them) to WebP/GIF/thumbnail renditions
   decode-layer  decode a 0x27 layer file to WebP and/or layered PSD
   download      download + decode one artwork by gallery id (needs credentials)
   download-user download every artwork of a user      (needs credentials)
+  pack          import/export/compact/verify/train/bench a packfile store of .dat blobs
+  frames        import/shared/stats/compact a frame-level dedup store of decoded frames
+  mock          serve a local mock Divoom API, or benchmark the client against one
 
 Credentials (for the download commands) come from the environment
 (``SERVOOM_EMAIL`` / ``SERVOOM_MD5_PASSWORD``) or a ``credentials.py`` — see
@@ -14,31 +17,132 @@ Credentials (for the download commands) come from the environment
 from __future__ import annotations
 
 import argparse
+import io
 import os
+from dataclasses import dataclass
 from pathlib import Path
 
 from .layer_file_decoder import LayerFileDecoder
 from .logging import configure, get_logger
+from .pipeline import Pipeline
+from .renditions import OutputSpec, render_outputs
 from .pixel_bean_decoder import PixelBeanDecoder
+from .scheduler import (
+    MemoryBudget, default_budget_bytes, estimate_peak_bytes, interleave_by_size,
+)
+from .sinks import open_sink
 
 log = get_logger(__name__)
 
 
-def _decode_one(path: Path, out_dir: Path, fmt: str) -> bool:
-    bean = PixelBeanDecoder.decode_file(str(path))
-    if bean is None:
-        log.warning("[SKIP] unsupported/failed: %s", path.name)
-        return False
-    out_dir.mkdir(parents=True, exist_ok=True)
-    stem = path.stem.split("_")[0] or path.stem
-    out = out_dir / f"{stem}.{fmt}"
-    if fmt == "gif":
-        bean.save_to_gif(str(out))
-    else:
-        bean.save_to_webp(str(out))
-    log.info("[OK] %s -> %s (%d frames, %dx%d)",
-             path.name, out.name, bean.total_frames, bean.width, bean.height)
-    return True
+@dataclass
+class _DecodeJob:
+    path: Path
+    charge: int = 0  # bytes reserved against the memory budget until encoded
+    data: bytes = None
+    bean: object = None
+    slab: object = None  # FrameDescriptor while ``bean``'s frames live in a shared slab
+    payload: dict = None  # OutputSpec -> encoded file bytes
+
+
+def _read_stage(budget: MemoryBudget, estimates: dict):
+    def read(path: Path):
+        job = _DecodeJob(path, charge=budget.acquire(estimates.get(path, 0)))
+        try:
+            job.data = path.read_bytes()
+        except Exception:
+            budget.release(job.charge)
+            raise
+        return job
+    return read
+
+
+def _decode_bytes(data: bytes):
+    return PixelBeanDecoder.decode_stream(io.BytesIO(data))
+
+
+def _decode_in_pool(pool, ring, job: _DecodeJob, data: bytes):
+    """Decode on ``pool``; frames come back through a ``ring`` slab when one is free."""
+    from .frame_transport import FrameDescriptor, decode_bytes_into_slab
+
+    slot = ring.acquire() if ring else None
+    if slot is None:
+        return pool.submit(_decode_bytes, data).result()
+    try:
+        item = pool.submit(decode_bytes_into_slab, data, ring.name, slot,
+                           ring.slot_bytes).result()
+    except Exception:
+        ring.release(slot)
+        raise
+    if not isinstance(item, FrameDescriptor):
+        ring.release(slot)
+        return item
+    job.slab = item
+    return ring.view(item)
+
+
+def _decode_stage(pool, ring, budget: MemoryBudget):
+    def decode(job: _DecodeJob):
+        try:
+            data, job.data = job.data, None
+            job.bean = _decode_in_pool(pool, ring, job, data) if pool else _decode_bytes(data)
+        except Exception:
+            budget.release(job.charge)
+            raise
+        if job.bean is None:
+            budget.release(job.charge)
+            log.warning("[SKIP] unsupported/failed: %s", job.path.name)
+            return None
+        return job
+    return decode
+
+
+def _encode_stage(specs, ring, budget: MemoryBudget):
+    def encode(job: _DecodeJob):
+        try:
+            job.payload = render_outputs(job.bean, specs)
+        finally:
+            if job.slab is not None:  # frames are views into the slab: done with them now
+                ring.release(job.slab)
+                job.slab = None
+            budget.release(job.charge)
+        return job
+    return encode
+
+
+def _slab_ring(slots: int, headers):
+    """A shared-memory ring sized for the largest file, or ``None`` if /dev/shm can't hold it.
+
+    Without it every decoded bean is pickled back from the process pool.
+    """
+    from .frame_transport import DEFAULT_SLOT_BYTES, FrameSlabRing
+
+    slot_bytes = min(DEFAULT_SLOT_BYTES, max((h.raw_bytes for h in headers if h), default=0))
+    if slot_bytes <= 0:
+        return None
+    if os.path.isdir("/dev/shm"):  # tmpfs pages are only backed on write: check up front
+        import shutil
+
+        slots = min(slots, shutil.disk_usage("/dev/shm").free // 2 // slot_bytes)
+    if slots < 1:
+        return None
+    try:
+        return FrameSlabRing(slots=slots, slot_bytes=slot_bytes)
+    except OSError as exc:
+        log.debug("No shared-memory frame transport: %s", exc)
+        return None
+
+
+def _write_stage(sink):
+    def write(job: _DecodeJob):
+        bean = job.bean
+        stem = job.path.stem.split("_")[0] or job.path.stem
+        names = [sink.write(stem, spec.filename(stem), payload)
+                 for spec, payload in job.payload.items()]
+        log.info("[OK] %s -> %s (%d frames, %dx%d)", job.path.name, ", ".join(names),
+                 bean.total_frames, bean.width, bean.height)
+        return job.path
+    return write
 
 
 def _cmd_decode(args) -> int:
@@ -48,8 +152,47 @@ def _cmd_decode(args) -> int:
     if not paths:
         log.error("No .dat files at %s", src)
         return 1
-    ok = sum(_decode_one(p, out_dir, args.format) for p in paths)
+    try:
+        specs = [OutputSpec.parse(o) for o in args.output] if args.output else [OutputSpec(args.format)]
+    except ValueError as exc:
+        log.error("%s", exc)
+        return 2
+    jobs = max(1, args.jobs)
+    encode_jobs = max(1, args.encode_jobs or jobs)
+    budget = MemoryBudget(int(args.memory_budget * 2**20) if args.memory_budget
+                          else default_budget_bytes())
+    estimates, headers = {}, []
+    for p in paths:
+        header = PixelBeanDecoder.probe(str(p))
+        scales = [s.scale_for(header.width) for s in specs] if header else ()
+        estimates[p] = estimate_peak_bytes(header, scales=scales)
+        headers.append(header)
+    paths = interleave_by_size(paths, estimates.get)
+    sink = open_sink(args.sink, out_dir, max_bytes=int(args.archive_size * 2**20))
+    pool = ring = None
+    if jobs > 1:  # the decode kernels are pure Python: use processes for real parallelism
+        from concurrent.futures import ProcessPoolExecutor
+        pool = ProcessPoolExecutor(max_workers=jobs)
+        # A slab per bean being decoded or encoded; beans past that are pickled back
+        ring = _slab_ring(jobs + encode_jobs, headers)
+    pipeline = Pipeline([
+        ("read", _read_stage(budget, estimates), 1),
+        ("decode", _decode_stage(pool, ring, budget), jobs),
+        ("encode", _encode_stage(specs, ring, budget), encode_jobs),
+        ("write", _write_stage(sink), 1),
+    ], queue_size=2 * max(jobs, encode_jobs))
+    try:
+        ok = sum(1 for _ in pipeline.run(paths))
+    finally:
+        sink.close()
+        if pool:
+            pool.shutdown()
+        if ring:
+            ring.close()
     log.info("Decoded %d/%d", ok, len(paths))
+    if len(paths) > 1:
+        log.info("Stage utilization: %s", pipeline.report())
+        log.debug("Peak estimated memory in flight: %.1f MB", budget.peak / 2**20)
     return 0 if ok else 1
 
 
@@ -67,6 +210,108 @@ def _cmd_decode_layer(args) -> int:
     return 0
 
 
+def _cmd_pack(args) -> int:
+    from .packstore import PackStore
+
+    if args.action in ("import", "export") and not args.path:
+        log.error("pack %s needs a directory argument", args.action)
+        return 2
+    with PackStore(args.store) as store:
+        if args.action == "import":
+            log.info("Imported %d files into %s", store.import_tree(args.path), args.store)
+        elif args.action == "export":
+            log.info("Exported %d files to %s", store.export_tree(args.path), args.path)
+        elif args.action == "compact":
+            log.info("Compacted %s: freed %d bytes", args.store, store.compact())
+        elif args.action == "train":
+            trained = store.train_dictionaries()
+            log.info("Archival mode: dictionaries for formats %s", sorted(trained) or "none")
+        elif args.action == "bench":
+            from .packstore import benchmark_dictionaries
+
+            for mode, r in benchmark_dictionaries(store).items():
+                log.info("%-10s %8d bytes  ratio %5.2fx  read %.3f ms  read+decode %.2f ms",
+                         mode, r["bytes"], r["ratio"], r["read_ms"], r["decode_ms"])
+        else:
+            bad = store.verify()
+            for key in bad:
+                log.error("[BAD] %s", key)
+            log.info("Verified %d blobs, %d bad", len(store), len(bad))
+            return 1 if bad else 0
+    return 0
+
+
+def _artwork_key(path: Path) -> str:
+    """``4130000_example.dat`` -> ``4130000`` (the GalleryId prefix), else the stem."""
+    head = path.stem.split("_", 1)[0]
+    return head if head.isdigit() else path.stem
+
+
+def _cmd_frames(args) -> int:
+    from .frame_store import FrameStore
+
+    if args.action in ("import", "shared") and not args.target:
+        log.error("frames %s needs a %s argument", args.action,
+                  "path" if args.action == "import" else "key")
+        return 2
+    with FrameStore(args.store) as store:
+        if args.action == "import":
+            src = Path(args.target)
+            paths = sorted(src.rglob("*.dat")) if src.is_dir() else [src]
+            beans = ((_artwork_key(p), PixelBeanDecoder.decode_file(str(p))) for p in paths)
+            log.info("Imported %d artworks into %s", store.import_beans(beans), args.store)
+        elif args.action == "shared":
+            if args.target not in store:
+                log.error("No artwork %r in %s", args.target, args.store)
+                return 1
+            for key, shared in store.sharing(args.target, min_shared=args.min_shared):
+                log.info("%s  %d shared frames", key, shared)
+            for key in store.remixes(args.target):
+                log.info("%s  remix (OriginalGalleryId)", key)
+        elif args.action == "compact":
+            log.info("Compacted %s: freed %d bytes", args.store, store.compact())
+        else:
+            s = store.stats()
+            log.info("%d artworks, %d frame refs, %d unique frames; %d raw -> %d stored "
+                     "bytes (%.1fx)", s["artworks"], s["frame_refs"], s["unique_frames"],
+                     s["raw_bytes"], s["stored_bytes"], s["ratio"])
+    return 0
+
+
+def _cmd_mock(args) -> int:
+    import time
+    from dataclasses import replace
+
+    from .mock_server import MockConfig, MockDivoomServer, run_benchmark
+
+    config = MockConfig(items=args.items, page_cap=args.page_cap, latency=args.latency,
+                        throttle_rps=args.throttle_rps, failure_rate=args.failure_rate,
+                        bandwidth=args.bandwidth * 1e6 if args.bandwidth else None)
+    with MockDivoomServer(config, port=args.port) as server:
+        if args.action == "serve":
+            log.info("Point Settings(api_base=%r, file_base=%r) at it; Ctrl+C stops",
+                     server.url, server.url + "/files")
+            try:
+                while True:
+                    time.sleep(3600)
+            except KeyboardInterrupt:
+                return 0
+        settings = server.settings()
+        if args.batch_size:
+            settings = replace(settings, batch_size=args.batch_size)
+        settings = replace(settings, page_concurrency=args.page_concurrency,
+                           batch_tuning=args.tune, batch_state_path=args.tune_state)
+        r = run_benchmark(settings, downloads=args.downloads)
+        s = server.stats
+    log.info("crawl     %6d items in %.2f s  %8.1f items/s", r["crawl_items"], r["crawl_s"],
+             r["items_per_s"])
+    log.info("download  %6d files in %.2f s  %8.2f MB/s", r["downloads"], r["download_s"],
+             r["mb_per_s"])
+    log.info("server    %d requests, %d throttled, %d failed, %d bytes sent", s.requests,
+             s.throttled, s.failed, s.bytes_sent)
+    return 0
+
+
 def _client(args):
     from .client import DivoomClient  # imported lazily so decode works without requests
 
@@ -102,6 +347,21 @@ def build_parser() -> argparse.ArgumentParser:
     d.add_argument("path")
     d.add_argument("-o", "--out", default="out")
     d.add_argument("-f", "--format", choices=["webp", "gif"], default="webp")
+    d.add_argument("--output", action="append", metavar="SPEC",
+                   help="rendition to write, repeatable: webp|gif|thumb[@Nx|@Npx], e.g. "
+                        "--output webp@4x --output gif --output thumb@64 (overrides -f)")
+    d.add_argument("--sink", choices=["dir", "tar", "zip"], default="dir",
+                   help="write files into --out, or stream them into rolling archives "
+                        "there with an export.index.jsonl (GalleryId -> archive + offset)")
+    d.add_argument("--archive-size", type=float, default=1024, metavar="MB",
+                   help="start a new archive after this many MB (tar/zip sinks)")
+    d.add_argument("-j", "--jobs", type=int, default=1,
+                   help="decode workers (processes when > 1)")
+    d.add_argument("--encode-jobs", type=int, default=None,
+                   help="encode worker threads (default: same as --jobs)")
+    d.add_argument("--memory-budget", type=float, default=None, metavar="MB",
+                   help="cap on estimated decode+encode memory in flight "
+                        "(default: half of physical RAM)")
     d.set_defaults(func=_cmd_decode)
 
     dl = sub.add_parser("decode-layer", help="decode a 0x27 layer file to WebP/PSD")
@@ -110,6 +370,43 @@ def build_parser() -> argparse.ArgumentParser:
     dl.add_argument("--psd", action="store_true", help="also write a layered PSD")
     dl.set_defaults(func=_cmd_decode_layer)
 
+    pk = sub.add_parser("pack", help="manage a packfile store of raw .dat blobs")
+    pk.add_argument("action",
+                    choices=["import", "export", "compact", "verify", "train", "bench"])
+    pk.add_argument("store", help="packfile store directory")
+    pk.add_argument("path", nargs="?", help="downloads/ tree to import, or export target")
+    pk.set_defaults(func=_cmd_pack)
+
+    fr = sub.add_parser("frames", help="frame-level dedup store of decoded frames")
+    fr.add_argument("action", choices=["import", "shared", "stats", "compact"])
+    fr.add_argument("store", help="frame store directory")
+    fr.add_argument("target", nargs="?", help=".dat file/tree to import, or artwork key")
+    fr.add_argument("--min-shared", type=int, default=1,
+                    help="shared: only list artworks with at least this many common frames")
+    fr.set_defaults(func=_cmd_frames)
+
+    mk = sub.add_parser("mock", help="local mock Divoom API server / client benchmark")
+    mk.add_argument("action", choices=["serve", "bench"])
+    mk.add_argument("--port", type=int, default=0, help="listen port (default: any free)")
+    mk.add_argument("--items", type=int, default=1000, help="synthetic catalogue size")
+    mk.add_argument("--latency", type=float, default=0.0, help="seconds added per response")
+    mk.add_argument("--page-cap", type=int, default=None,
+                    help="most items per listing page, whatever EndNum asks for")
+    mk.add_argument("--throttle-rps", type=float, default=None,
+                    help="answer with a throttling ReturnCode above this request rate")
+    mk.add_argument("--failure-rate", type=float, default=0.0,
+                    help="fraction of requests answered with HTTP 503")
+    mk.add_argument("--bandwidth", type=float, default=None, metavar="MB/s",
+                    help="per-download bandwidth cap")
+    mk.add_argument("--batch-size", type=int, default=None, help="bench: client batch_size")
+    mk.add_argument("--page-concurrency", type=int, default=1,
+                    help="bench: listing windows requested at once")
+    mk.add_argument("--tune", action="store_true", help="bench: adaptive batch_size")
+    mk.add_argument("--tune-state", default=None, metavar="JSON",
+                    help="bench: where the tuner remembers sizes (default: user cache)")
+    mk.add_argument("--downloads", type=int, default=100, help="bench: files to download")
+    mk.set_defaults(func=_cmd_mock)
+
     for name, help_text, extra in (
         ("download", "download + decode one artwork by gallery id",
          [("gallery_id", int)]),
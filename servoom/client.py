@@ -8,13 +8,15 @@ This class just wires them together with auth.
 from __future__ import annotations
 
 import os
-from typing import Dict, List, Optional, Tuple
+import time
+from concurrent.futures import FIRST_COMPLETED, ThreadPoolExecutor, wait
+from typing import Dict, Iterable, Iterator, List, NamedTuple, Optional, Tuple, Union
 
 from . import csv_export
 from .config import DEFAULT_SETTINGS, Settings
-from .const import ApiEndpoint, Server
+from .const import ApiEndpoint
 from .credentials import load_credentials
-from .http import DivoomSession, paginate
+from .http import BatchTuner, DivoomSession, default_tuner_path, paginate
 from .logging import get_logger
 from .pixel_bean import PixelBean, PixelBeanState
 from .pixel_bean_decoder import PixelBeanDecoder
@@ -23,6 +25,16 @@ from .util import sanitize_filename, safe_console_text
 log = get_logger(__name__)
 
 
+class FetchFailed(NamedTuple):
+    """Yielded by :meth:`DivoomClient.fetch_artwork_infos` for an id whose metadata could
+    not be fetched: still throttled after every retry, or a transport error. ``None``
+    means the API answered that there is no such artwork. Falsy, like ``None``."""
+    reason: str
+
+    def __bool__(self) -> bool:
+        return False
+
+
 class DivoomClient:
     """Client for the Divoom cloud API. Call :meth:`login` before any fetch/download."""
 
@@ -38,6 +50,9 @@ class DivoomClient:
         self._md5_password = creds.md5_password
         self._settings = settings
         self._session = DivoomSession(settings)
+        self._tuner = BatchTuner(
+            settings.batch_size, path=settings.batch_state_path or default_tuner_path()
+        ) if settings.batch_tuning else None
         self.token: Optional[str] = None
         self.user_id: Optional[int] = None
 
@@ -83,6 +98,9 @@ class DivoomClient:
             keep=self._keep,
             limit=limit,
             on_page=lambda start, total: log.info("  %s: %d collected", endpoint.name, total),
+            concurrency=self._settings.page_concurrency,
+            tuner=self._tuner,
+            throttle_codes=self._settings.throttle_codes,
         ))
         log.info("Fetched %d items from %s", len(items), endpoint.name)
         return items
@@ -90,14 +108,86 @@ class DivoomClient:
     # -- single artwork -----------------------------------------------------
     def fetch_artwork_info(self, gallery_id: int) -> Optional[Dict]:
         """Fetch artwork metadata by gallery ID (or None on error)."""
+        return self._artwork_info(gallery_id)[0]
+
+    def _artwork_info(self, gallery_id: int) -> Tuple[Optional[Dict], int]:
+        """``(metadata or None, ReturnCode)`` for one gallery ID."""
         resp = self._session.post_json(
             ApiEndpoint.GET_GALLERY_INFO.value, {**self._auth(), "GalleryId": gallery_id}
         )
-        if resp.get("ReturnCode", 0) != 0:
-            log.error("fetch_artwork_info failed: ReturnCode %s", resp.get("ReturnCode"))
-            return None
+        code = resp.get("ReturnCode", 0)
+        if code != 0:
+            if code not in self._settings.throttle_codes:
+                log.error("fetch_artwork_info failed: ReturnCode %s", code)
+            return None, code
         resp["GalleryId"] = gallery_id  # not always echoed back
-        return resp
+        return resp, 0
+
+    def fetch_artwork_infos(self, gallery_ids: Iterable[int], cache=None,
+                            max_age: Optional[float] = None,
+                            workers: Optional[int] = None
+                            ) -> Iterator[Tuple[int, Union[Dict, FetchFailed, None]]]:
+        """Fetch metadata for many gallery IDs; yields ``(gallery_id, metadata or None)``.
+
+        IDs are deduplicated. With a :class:`~servoom.metadata_cache.MetadataCache`, hits
+        (fetched within ``max_age`` seconds, if given) are yielded first and every fetched
+        record is stored. Misses are fetched by ``workers`` threads (default
+        ``settings.fetch_workers``) behind the session's shared rate limiter, and yielded
+        as they complete, so results are not in input order.
+
+        A throttled ID is retried ``settings.max_retries`` times, waiting
+        ``settings.retry_delay`` seconds and doubling. If it stays throttled, or its request
+        fails outright, it is yielded with a :class:`FetchFailed` instead of ``None``, so it
+        can be retried later rather than recorded as missing.
+        """
+        ids = list(dict.fromkeys(int(g) for g in gallery_ids))
+        cached = cache.get_many(ids, max_age) if cache is not None else {}
+        for gallery_id in ids:
+            if gallery_id in cached:
+                yield gallery_id, cached[gallery_id]
+        misses = iter([g for g in ids if g not in cached])
+        log.info("Fetching metadata: %d ids, %d cached", len(ids), len(cached))
+        workers = workers or self._settings.fetch_workers
+
+        def fetch(gallery_id: int) -> Union[Dict, FetchFailed, None]:
+            retries = self._settings.max_retries
+            for attempt in range(retries + 1):
+                try:
+                    metadata, code = self._artwork_info(gallery_id)
+                except Exception as exc:
+                    log.warning("fetch_artwork_info(%s) failed: %s", gallery_id, exc)
+                    return FetchFailed(str(exc))
+                if code not in self._settings.throttle_codes:
+                    return metadata
+                if attempt < retries:
+                    time.sleep(self._settings.retry_delay * 2 ** attempt)
+            log.warning("fetch_artwork_info(%s) still throttled after %d retries",
+                        gallery_id, retries)
+            return FetchFailed(f"throttled (ReturnCode {code})")
+
+        with ThreadPoolExecutor(workers) as pool:
+            in_flight = {}
+
+            def submit_next() -> None:
+                gallery_id = next(misses, None)
+                if gallery_id is not None:
+                    in_flight[pool.submit(fetch, gallery_id)] = gallery_id
+
+            for _ in range(workers * 2):  # bounded: never queue the whole id list
+                submit_next()
+            try:
+                while in_flight:
+                    done, _ = wait(in_flight, return_when=FIRST_COMPLETED)
+                    for future in done:
+                        gallery_id = in_flight.pop(future)
+                        submit_next()
+                        metadata = future.result()
+                        if metadata and cache is not None:
+                            cache.put(gallery_id, metadata)
+                        yield gallery_id, metadata
+            finally:
+                for future in in_flight:
+                    future.cancel()
 
     def download_art_by_id(self, gallery_id: int, output_dir: Optional[str] = None
                            ) -> Tuple[PixelBean, str]:
@@ -108,8 +198,13 @@ class DivoomClient:
         bean = PixelBean(metadata=metadata)
         return bean, self.download_art(bean, output_dir=output_dir)
 
-    def download_art(self, pixel_bean: PixelBean, output_dir: Optional[str] = None) -> str:
-        """Download the .dat file for ``pixel_bean`` and advance its state to DOWNLOADED."""
+    def download_art(self, pixel_bean: PixelBean, output_dir: Optional[str] = None,
+                     store=None) -> str:
+        """Download the .dat file for ``pixel_bean`` and advance its state to DOWNLOADED.
+
+        With a :class:`~servoom.packstore.PackStore`, the blob is appended to the store under
+        its FileId instead of written as its own file; the returned locator is ``store.uri``.
+        """
         if pixel_bean.state != PixelBeanState.METADATA_ONLY:
             raise ValueError(
                 f"Cannot download: state is {pixel_bean.state.value}, expected METADATA_ONLY"
@@ -118,13 +213,24 @@ class DivoomClient:
         if not file_id:
             raise ValueError("PixelBean missing FileId in metadata")
 
+        if store is not None:
+            try:
+                resp = self._session.get(self._session.file_url(file_id))
+                resp.raise_for_status()
+                store.put(file_id, resp.content)
+            except Exception as exc:
+                raise RuntimeError(f"Failed to download file: {exc}") from exc
+            pixel_bean.update_from_download(store.uri(file_id))
+            log.info("Downloaded: %s -> %s", file_id, store.root)
+            return store.uri(file_id)
+
         output_dir = output_dir or "downloads"
         os.makedirs(output_dir, exist_ok=True)
         name = sanitize_filename(pixel_bean.file_name or f"art_{pixel_bean.gallery_id}")
         output_path = os.path.join(output_dir, f"{pixel_bean.gallery_id}_{name}.dat")
 
         try:
-            resp = self._session.get(f"https://{Server.FILE.value}/{file_id}", stream=True)
+            resp = self._session.get(self._session.file_url(file_id), stream=True)
             resp.raise_for_status()
             with open(output_path, "wb") as fh:
                 for chunk in resp.iter_content(chunk_size=8192):
@@ -137,17 +243,19 @@ class DivoomClient:
         log.info("Downloaded: %s", safe_console_text(os.path.basename(output_path)))
         return output_path
 
-    def decode_art(self, pixel_bean: PixelBean) -> PixelBean:
-        """Decode a downloaded file and advance ``pixel_bean`` to COMPLETE."""
+    def decode_art(self, pixel_bean: PixelBean, store=None) -> PixelBean:
+        """Decode a downloaded file (or its blob in ``store``) and advance to COMPLETE."""
         if pixel_bean.state != PixelBeanState.DOWNLOADED:
             raise ValueError(
                 f"Cannot decode: state is {pixel_bean.state.value}, expected DOWNLOADED"
             )
         file_path = pixel_bean.file_path
-        if not file_path or not os.path.exists(file_path):
+        if store is not None and pixel_bean.file_id in store:
+            decoded = store.decode(pixel_bean.file_id)
+        elif not file_path or not os.path.exists(file_path):
             raise ValueError(f"File not found: {file_path}")
-
-        decoded = PixelBeanDecoder.decode_file(file_path)
+        else:
+            decoded = PixelBeanDecoder.decode_file(file_path)
         if decoded is None:
             raise RuntimeError("Failed to decode file: unsupported format or corrupted file")
         pixel_bean.update_from_decode(
@@ -235,33 +343,37 @@ class DivoomClient:
     def fetch_someone_arts_as_beans(self, target_user_id: int, **kwargs) -> List[PixelBean]:
         return [PixelBean(metadata=a) for a in self.fetch_someone_arts(target_user_id, **kwargs)]
 
-    def download_my_arts(self, output_dir: Optional[str] = None, **kwargs) -> List[str]:
+    def download_my_arts(self, output_dir: Optional[str] = None, store=None,
+                         **kwargs) -> List[str]:
         """Download every upload of the current user."""
         output_dir = output_dir or os.path.join("downloads", "my_arts")
-        return self._download_beans(self.fetch_my_arts_as_beans(**kwargs), output_dir)
+        return self._download_beans(self.fetch_my_arts_as_beans(**kwargs), output_dir, store)
 
     def download_someone_arts(self, target_user_id: int, output_dir: Optional[str] = None,
-                              **kwargs) -> List[str]:
+                              store=None, **kwargs) -> List[str]:
         """Download every upload of ``target_user_id``."""
         output_dir = output_dir or os.path.join("downloads", str(target_user_id))
         return self._download_beans(
-            self.fetch_someone_arts_as_beans(target_user_id, **kwargs), output_dir
+            self.fetch_someone_arts_as_beans(target_user_id, **kwargs), output_dir, store
         )
 
-    def _download_beans(self, beans: List[PixelBean], output_dir: str) -> List[str]:
-        os.makedirs(output_dir, exist_ok=True)
+    def _download_beans(self, beans: List[PixelBean], output_dir: str,
+                        store=None) -> List[str]:
+        if store is None:
+            os.makedirs(output_dir, exist_ok=True)
         if not beans:
             log.info("No arts to download")
             return []
-        log.info("Downloading %d files to %s", len(beans), output_dir)
+        target = store.root if store is not None else output_dir
+        log.info("Downloading %d files to %s", len(beans), target)
         paths = []
         for i, bean in enumerate(beans, 1):
             try:
-                paths.append(self.download_art(bean, output_dir=output_dir))
+                paths.append(self.download_art(bean, output_dir=output_dir, store=store))
             except Exception as exc:
                 log.warning("  [%d/%d] Failed to download %s: %s",
                             i, len(beans), bean.gallery_id or i, exc)
-        log.info("Downloaded %d/%d files to %s", len(paths), len(beans), output_dir)
+        log.info("Downloaded %d/%d files to %s", len(paths), len(beans), target)
         return paths
 
     def export_artworks_to_csv(self, beans, base_filename: str = "artworks",
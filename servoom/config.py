@@ -7,7 +7,7 @@ CSV field mappings in :mod:`servoom.csv_export`. This module is deliberately sma
 from __future__ import annotations
 
 from dataclasses import dataclass, field
-from typing import Dict
+from typing import Dict, Optional, Tuple
 
 USER_AGENT = "Aurabox/3.1.10 (iPad; iOS 14.8; Scale/2.00)"
 
@@ -25,6 +25,20 @@ class Settings:
     """Tunable client settings. Immutable; override per-client by constructing a new one."""
 
     batch_size: int = 40
+    page_concurrency: int = 1  # listing windows requested at once (see http.paginate)
+    # Adapt batch_size per endpoint (http.BatchTuner), remembered in batch_state_path
+    # (default ~/.cache/servoom/batch_sizes.json)
+    batch_tuning: bool = False
+    batch_state_path: Optional[str] = None
+    # ReturnCodes meaning "too many requests": retried with backoff (and a smaller window
+    # when tuning) instead of ending the listing. servoom.mock_server sends throttle_code.
+    throttle_codes: Tuple[int, ...] = (10,)
+    fetch_workers: int = 8  # concurrent requests in DivoomClient.fetch_artwork_infos
+    requests_per_second: Optional[float] = None  # shared cap on API calls (all threads)
+    # Persistent API response cache (SQLite file); TTLs in seconds per endpoint path,
+    # default servoom.response_cache.DEFAULT_TTLS
+    response_cache_path: Optional[str] = None
+    response_cache_ttls: Optional[Dict[str, float]] = None
     max_retries: int = 3
     request_timeout: int = 10
     retry_delay: int = 1  # seconds between retries
@@ -32,6 +46,10 @@ class Settings:
     respect_hide_flag: bool = True
     headers: Dict[str, str] = field(default_factory=lambda: dict(DEFAULT_HEADERS))
     output_dir: str = "out"
+    # URL prefixes replacing https://<Server.API> / https://<Server.FILE>, e.g. a local
+    # servoom.mock_server instance ("http://127.0.0.1:8123")
+    api_base: Optional[str] = None
+    file_base: Optional[str] = None
 
 
 DEFAULT_SETTINGS = Settings()
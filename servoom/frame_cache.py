@@ -0,0 +1,153 @@
+"""On-disk cache of decoded frames, keyed by file content and decoder version.
+
+Thumbnails, similarity hashing, colour stats and re-exports tend to decode the same
+``.dat`` again and again. With a :class:`FrameCache`, ``PixelBeanDecoder.decode_file(path,
+cache=cache)`` first hashes the file's bytes. On a hit it returns frames that are
+``mmap``'d straight out of a raw cache entry, with no decoding at all. On a miss it
+decodes and stores the result.
+
+Entry key: ``sha256(file bytes)`` plus :data:`~servoom.pixel_bean_decoder.DECODER_VERSION`.
+A decoder change therefore never serves stale pixels, and renamed or re-downloaded copies
+of a file share one entry. Entry layout: a 64-byte header (magic, frames, height, width,
+speed, row/column count), then ``frames * H * W * 3`` raw RGB bytes.
+
+Several processes can share one cache directory. Entries are written to a temp file and
+published with an atomic ``os.replace``, so readers never see a partial entry. Hits
+refresh the entry's mtime, and eviction removes the least recently used entries once the
+directory passes ``max_bytes``. A concurrent eviction at worst turns a hit into a miss.
+Deleting a file that another process has mapped is safe on POSIX.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import io
+import mmap
+import os
+import struct
+import tempfile
+from pathlib import Path
+from typing import Optional, Union
+
+import numpy as np
+
+from .logging import get_logger
+from .pixel_bean import PixelBean
+from .pixel_bean_decoder import DECODER_VERSION, PixelBeanDecoder
+
+log = get_logger(__name__)
+
+_MAGIC = b'SVFC'
+_HEADER = struct.Struct('>4sIHHHBB')
+_HEADER_SIZE = 64  # frames start 64-byte aligned
+_SUFFIX = '.frames'
+DEFAULT_MAX_BYTES = 2 << 30
+
+
+class FrameCache:
+    """Size-bounded LRU cache of decoded frames under ``root``."""
+
+    def __init__(self, root: Union[str, Path], max_bytes: int = DEFAULT_MAX_BYTES):
+        self.root = Path(root)
+        self.root.mkdir(parents=True, exist_ok=True)
+        self.max_bytes = max_bytes
+        self.hits = 0
+        self.misses = 0
+
+    @staticmethod
+    def key_for(data: bytes) -> str:
+        return f'{hashlib.sha256(data).hexdigest()}-v{DECODER_VERSION}'
+
+    def _path(self, key: str) -> Path:
+        return self.root / key[:2] / (key + _SUFFIX)
+
+    # -- lookups ---------------------------------------------------------------
+    def get(self, key: str) -> Optional[PixelBean]:
+        """The cached bean for ``key`` (frames are read-only mmap views), or ``None``."""
+        path = self._path(key)
+        try:
+            with open(path, 'rb') as fp:
+                mapped = mmap.mmap(fp.fileno(), 0, access=mmap.ACCESS_READ)
+            os.utime(path)  # LRU: a hit makes the entry most recently used
+        except (FileNotFoundError, ValueError):  # missing, evicted, or empty
+            return None
+        if len(mapped) >= _HEADER_SIZE:
+            magic, frames, height, width, speed, rows, cols = _HEADER.unpack_from(mapped, 0)
+        if (len(mapped) < _HEADER_SIZE or magic != _MAGIC
+                or len(mapped) != _HEADER_SIZE + frames * height * width * 3):
+            log.warning('Discarding corrupt cache entry %s', path)
+            self._remove(path)
+            return None
+        array = np.ndarray((frames, height, width, 3), np.uint8, mapped, _HEADER_SIZE)
+        return PixelBean(metadata={}, total_frames=frames, speed=speed, row_count=rows,
+                         column_count=cols, frames_data=list(array))
+
+    def put(self, key: str, bean: PixelBean) -> None:
+        frames = [np.ascontiguousarray(f, dtype=np.uint8) for f in bean.frames_data]
+        height, width = frames[0].shape[:2] if frames else (0, 0)
+        header = _HEADER.pack(_MAGIC, len(frames), height, width, bean.speed or 0,
+                              bean.row_count or 0, bean.column_count or 0)
+        path = self._path(key)
+        path.parent.mkdir(exist_ok=True)
+        fd, tmp = tempfile.mkstemp(dir=path.parent, suffix='.tmp')
+        try:
+            with os.fdopen(fd, 'wb') as fp:
+                fp.write(header.ljust(_HEADER_SIZE, b'\0'))
+                for frame in frames:
+                    fp.write(frame.data)
+            os.replace(tmp, path)
+        except BaseException:
+            self._remove(Path(tmp))
+            raise
+        self.evict()
+
+    def decode_file(self, file_path: str, executor=None, context=None) -> Optional[PixelBean]:
+        """Decode through the cache (what ``PixelBeanDecoder.decode_file(cache=...)`` calls)."""
+        with open(file_path, 'rb') as fp:
+            data = fp.read()
+        key = self.key_for(data)
+        bean = self.get(key)
+        if bean is not None:
+            self.hits += 1
+            return bean
+        self.misses += 1
+        bean = PixelBeanDecoder.decode_stream(io.BytesIO(data), executor, context)
+        if bean is not None and bean.total_frames:
+            self.put(key, bean)
+        return bean
+
+    # -- eviction --------------------------------------------------------------------
+    def _entries(self):
+        for sub in os.scandir(self.root):
+            if not sub.is_dir():
+                continue
+            for entry in os.scandir(sub.path):
+                if entry.name.endswith(_SUFFIX):
+                    try:
+                        st = entry.stat()
+                    except FileNotFoundError:
+                        continue
+                    yield st.st_mtime, st.st_size, Path(entry.path)
+
+    def size(self) -> int:
+        return sum(size for _, size, _ in self._entries())
+
+    def evict(self) -> int:
+        """Delete least recently used entries until under ``max_bytes``; returns bytes freed."""
+        entries = sorted(self._entries())
+        total = sum(size for _, size, _ in entries)
+        freed = 0
+        for _, size, path in entries:
+            if total - freed <= self.max_bytes:
+                break
+            if self._remove(path):
+                freed += size
+        return freed
+
+    @staticmethod
+    def _remove(path: Path) -> bool:
+        try:
+            path.unlink()
+            return True
+        except FileNotFoundError:  # another process got there first
+            return False
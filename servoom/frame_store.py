@@ -0,0 +1,284 @@
+"""Frame-level content-addressed store across all artworks.
+
+Many uploads share individual frames: template backgrounds, reposted loops, and remixes
+(linked through ``OriginalGalleryId``). A :class:`FrameStore` hashes every decoded frame,
+stores each unique frame once (zstd-compressed, in a :class:`~servoom.packstore.PackStore`)
+and keeps each artwork as a list of frame references with their durations::
+
+    frames/
+      seg-00000.pack     one record per unique frame: height u16, width u16, zstd(RGB)
+      index.jsonl        frame hash -> segment, offset, length, crc
+    artworks.jsonl       one line per add/delete; the last line for a key wins
+                         {"key": "4130000", "original": 4120000, "speed": 100,
+                          "rows": 1, "cols": 1, "frames": [hash, ...], "durations": [ms, ...]}
+
+Consecutive identical frames collapse into one reference with a longer duration, so
+"hold" frames cost one entry. An in-memory inverted index (frame hash -> artworks) is
+built when the store opens. That makes :meth:`FrameStore.sharing` ("artworks sharing
+frames with X") a set lookup per frame, with no pixel comparison. It finds remixes that
+never set ``OriginalGalleryId``. Explicitly linked ones come from :meth:`FrameStore.remixes`.
+
+Frame hashes are exact (BLAKE2b over the shape and RGB bytes). A one-pixel edit makes a
+new frame, but the untouched frames of a remix still dedupe. One process writes at a time.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import json
+import struct
+from pathlib import Path
+from typing import Dict, Iterable, List, NamedTuple, Optional, Set, Tuple, Union
+
+import numpy as np
+
+from .logging import get_logger
+from .packstore import PackStore
+from .pixel_bean import PixelBean
+
+log = get_logger(__name__)
+
+_SHAPE = struct.Struct('>HH')
+_MANIFEST = 'artworks.jsonl'
+
+
+def frame_hash(frame: np.ndarray) -> str:
+    """Content hash of one ``(H, W, 3)`` uint8 frame."""
+    frame = np.ascontiguousarray(frame, dtype=np.uint8)
+    digest = hashlib.blake2b(_SHAPE.pack(*frame.shape[:2]), digest_size=16)
+    digest.update(frame.data)
+    return digest.hexdigest()
+
+
+class ArtworkRecord(NamedTuple):
+    key: str
+    original: Optional[int]
+    speed: int
+    row_count: int
+    column_count: int
+    frames: Tuple[str, ...]  # frame hashes, consecutive duplicates collapsed
+    durations: Tuple[int, ...]  # ms each reference is shown
+
+    @property
+    def total_frames(self) -> int:
+        if not self.speed:
+            return len(self.frames)
+        return sum(max(1, round(d / self.speed)) for d in self.durations)
+
+    def to_record(self) -> dict:
+        return {'key': self.key, 'original': self.original, 'speed': self.speed,
+                'rows': self.row_count, 'cols': self.column_count,
+                'frames': list(self.frames), 'durations': list(self.durations)}
+
+    @classmethod
+    def from_record(cls, rec: dict) -> 'ArtworkRecord':
+        return cls(rec['key'], rec.get('original'), rec['speed'], rec['rows'], rec['cols'],
+                   tuple(rec['frames']), tuple(rec['durations']))
+
+
+class FrameStore:
+    """Deduplicated storage of decoded frames, plus per-artwork frame lists."""
+
+    def __init__(self, root: Union[str, Path], level: int = 9):
+        self.root = Path(root)
+        self.root.mkdir(parents=True, exist_ok=True)
+        self.level = level
+        self._frames = PackStore(self.root / 'frames', archival=False)
+        self._artworks: Dict[str, ArtworkRecord] = {}
+        self._users: Dict[str, Set[str]] = {}  # frame hash -> artwork keys
+        self._load_manifest()
+        self._manifest = open(self.root / _MANIFEST, 'a', encoding='utf-8')
+
+    def _load_manifest(self) -> None:
+        path = self.root / _MANIFEST
+        if not path.exists():
+            return
+        with open(path, encoding='utf-8') as fp:
+            for line in fp:
+                if not line.strip():
+                    continue
+                try:
+                    rec = json.loads(line)
+                except ValueError:  # torn final line after a crash
+                    log.warning('Skipping unreadable manifest line in %s', path)
+                    continue
+                if rec.get('deleted'):
+                    self._forget(rec['key'])
+                else:
+                    self._remember(ArtworkRecord.from_record(rec))
+
+    def _remember(self, record: ArtworkRecord) -> None:
+        self._forget(record.key)
+        self._artworks[record.key] = record
+        for h in record.frames:
+            self._users.setdefault(h, set()).add(record.key)
+
+    def _forget(self, key: str) -> None:
+        old = self._artworks.pop(key, None)
+        if old is None:
+            return
+        for h in old.frames:
+            users = self._users.get(h)
+            if users is not None:
+                users.discard(key)
+                if not users:
+                    del self._users[h]
+
+    def _log(self, rec: dict) -> None:
+        self._manifest.write(json.dumps(rec) + '\n')
+        self._manifest.flush()
+
+    # -- mapping protocol ---------------------------------------------------
+    def __contains__(self, key) -> bool:
+        return str(key) in self._artworks
+
+    def __len__(self) -> int:
+        return len(self._artworks)
+
+    def keys(self) -> List[str]:
+        return list(self._artworks)
+
+    def record(self, key) -> ArtworkRecord:
+        return self._artworks[str(key)]
+
+    # -- writes -----------------------------------------------------------------
+    def add(self, key, bean: PixelBean, original: Optional[int] = None) -> ArtworkRecord:
+        """Store ``bean``'s frames under ``key`` (a GalleryId or any string).
+
+        ``original`` defaults to the bean's ``OriginalGalleryId`` metadata. Frames already
+        in the store are only referenced, not written again.
+        """
+        import zstandard
+
+        if original is None:
+            original = (bean.metadata or {}).get('OriginalGalleryId') or None
+        speed = bean.speed or 0
+        compressor = zstandard.ZstdCompressor(level=self.level)
+        hashes: List[str] = []
+        durations: List[int] = []
+        for frame in bean.frames_data:
+            frame = np.ascontiguousarray(frame, dtype=np.uint8)
+            h = frame_hash(frame)
+            if speed and hashes and hashes[-1] == h:
+                durations[-1] += speed  # a held frame: extend the previous reference
+                continue
+            if h not in self._frames:
+                self._frames.put(h, _SHAPE.pack(*frame.shape[:2]) +
+                                 compressor.compress(frame.data))
+            hashes.append(h)
+            durations.append(speed)
+        record = ArtworkRecord(str(key), int(original) if original else None, speed,
+                               bean.row_count or 0, bean.column_count or 0,
+                               tuple(hashes), tuple(durations))
+        self._remember(record)
+        self._log(record.to_record())
+        return record
+
+    def delete(self, key) -> None:
+        """Drop an artwork; frames nobody references any more go at the next :meth:`compact`."""
+        key = str(key)
+        if key in self._artworks:
+            self._forget(key)
+            self._log({'key': key, 'deleted': True})
+
+    # -- reads --------------------------------------------------------------------
+    def frame(self, h: str) -> np.ndarray:
+        """One stored frame by hash, as an ``(H, W, 3)`` uint8 array."""
+        import zstandard
+
+        blob = self._frames.get(h)
+        height, width = _SHAPE.unpack_from(blob, 0)
+        raw = zstandard.ZstdDecompressor().decompress(blob[_SHAPE.size:],
+                                                      max_output_size=height * width * 3)
+        return np.frombuffer(raw, np.uint8).reshape(height, width, 3)
+
+    def frames(self, key) -> List[np.ndarray]:
+        """The artwork's full frame sequence (held frames repeated, arrays shared)."""
+        record = self.record(key)
+        decoded: Dict[str, np.ndarray] = {}
+        out = []
+        for h, duration in zip(record.frames, record.durations):
+            if h not in decoded:
+                decoded[h] = self.frame(h)
+            repeat = max(1, round(duration / record.speed)) if record.speed else 1
+            out.extend([decoded[h]] * repeat)
+        return out
+
+    def to_pixel_bean(self, key) -> PixelBean:
+        record = self.record(key)
+        frames = self.frames(key)
+        metadata = {'GalleryId': int(record.key)} if record.key.isdigit() else {}
+        if record.original:
+            metadata['OriginalGalleryId'] = record.original
+        return PixelBean(metadata=metadata, total_frames=len(frames), speed=record.speed,
+                         row_count=record.row_count, column_count=record.column_count,
+                         frames_data=frames)
+
+    # -- queries ----------------------------------------------------------------------
+    def sharing(self, key, min_shared: int = 1) -> List[Tuple[str, int]]:
+        """Artworks sharing at least ``min_shared`` unique frames with ``key``.
+
+        Returns ``[(other_key, shared_frame_count), ...]``, most shared first.
+        """
+        key = str(key)
+        counts: Dict[str, int] = {}
+        for h in set(self.record(key).frames):
+            for other in self._users.get(h, ()):
+                if other != key:
+                    counts[other] = counts.get(other, 0) + 1
+        hits = [(other, n) for other, n in counts.items() if n >= min_shared]
+        return sorted(hits, key=lambda item: (-item[1], item[0]))
+
+    def remixes(self, key) -> List[str]:
+        """Artworks whose ``OriginalGalleryId`` is ``key``."""
+        key = str(key)
+        return sorted(r.key for r in self._artworks.values()
+                      if r.original is not None and str(r.original) == key)
+
+    def stats(self) -> dict:
+        """Frame references, unique frames and bytes stored vs. decoded size."""
+        refs = sum(len(r.frames) for r in self._artworks.values())
+        stored = sum(self._frames.entry(h).length for h in self._frames.keys())
+        raw = 0
+        for r in self._artworks.values():
+            if r.frames:
+                height, width = _SHAPE.unpack_from(self._frames.get(r.frames[0]), 0)
+                raw += r.total_frames * height * width * 3
+        return {'artworks': len(self._artworks), 'frame_refs': refs,
+                'unique_frames': len(self._users), 'raw_bytes': raw, 'stored_bytes': stored,
+                'ratio': raw / stored if stored else 1.0}
+
+    # -- maintenance ------------------------------------------------------------
+    def compact(self) -> int:
+        """Drop frames no artwork references, rewrite the manifest; returns bytes freed."""
+        for h in self._frames.keys():
+            if h not in self._users:
+                self._frames.delete(h)
+        freed = self._frames.compact()
+        self._manifest.close()
+        tmp = self.root / (_MANIFEST + '.tmp')
+        with open(tmp, 'w', encoding='utf-8') as fp:
+            for record in self._artworks.values():
+                fp.write(json.dumps(record.to_record()) + '\n')
+        tmp.replace(self.root / _MANIFEST)
+        self._manifest = open(self.root / _MANIFEST, 'a', encoding='utf-8')
+        return freed
+
+    def import_beans(self, items: Iterable[Tuple[str, PixelBean]]) -> int:
+        count = 0
+        for key, bean in items:
+            if bean is not None and bean.total_frames:
+                self.add(key, bean)
+                count += 1
+        return count
+
+    # -- lifecycle ----------------------------------------------------------------
+    def close(self) -> None:
+        self._manifest.close()
+        self._frames.close()
+
+    def __enter__(self) -> 'FrameStore':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
@@ -0,0 +1,237 @@
+"""Shared-memory hand-off of decoded frames between processes.
+
+A process-pool decode normally pickles every decoded :class:`PixelBean` back to the parent
+(up to ~50 MB for a 256x256 format-42 animation), which caps multi-process scaling. Here
+the parent preallocates a ring of fixed-size frame slabs in one
+``multiprocessing.shared_memory`` segment. A worker decodes a file, writes its frames into
+the slab it was given and returns only a small :class:`FrameDescriptor`. The parent, or an
+encoder process it forwards the descriptor to, maps the same slab with no copy.
+
+Typical use::
+
+    with FrameSlabRing(slots=4) as ring, ProcessPoolExecutor() as pool:
+        for path, item in decode_files_shared(paths, pool, ring):
+            bean = ring.view(item)          # frames are views into the slab
+            bean.save_to_webp(...)
+            ring.release(item)              # slot goes back to the ring
+
+A bean that does not fit in a slot falls back to being returned (pickled) as-is, so
+``item`` is a :class:`FrameDescriptor`, a :class:`PixelBean`, or ``None`` if decoding
+failed. ``view`` and ``release`` accept all three.
+"""
+
+from __future__ import annotations
+
+import io
+import sys
+import threading
+from collections import deque
+from contextlib import contextmanager
+from multiprocessing import resource_tracker, shared_memory
+from typing import Iterable, Iterator, NamedTuple, Optional, Tuple, Union
+
+import numpy as np
+
+from .logging import get_logger
+from .pixel_bean import PixelBean
+from .pixel_bean_decoder import PixelBeanDecoder
+
+log = get_logger(__name__)
+
+DEFAULT_SLOT_BYTES = 64 << 20  # fits the largest format-42 animations (256x256, ~260 frames)
+
+
+class FrameDescriptor(NamedTuple):
+    """Where a decoded bean's frames live: ``(frames, height, width, 3)`` uint8 at
+    ``offset`` in the shared segment ``shm_name``."""
+    shm_name: str
+    slot: int
+    offset: int
+    total_frames: int
+    height: int
+    width: int
+    speed: int
+    row_count: int
+    column_count: int
+
+    @property
+    def nbytes(self) -> int:
+        return self.total_frames * self.height * self.width * 3
+
+
+def _frames_view(buf, desc: FrameDescriptor) -> np.ndarray:
+    shape = (desc.total_frames, desc.height, desc.width, 3)
+    return np.ndarray(shape, dtype=np.uint8, buffer=buf, offset=desc.offset)
+
+
+def _bean_from_frames(desc: FrameDescriptor, frames: np.ndarray) -> PixelBean:
+    return PixelBean(
+        metadata={},
+        total_frames=desc.total_frames,
+        speed=desc.speed,
+        row_count=desc.row_count,
+        column_count=desc.column_count,
+        frames_data=list(frames),
+    )
+
+
+def _attach(name: str) -> shared_memory.SharedMemory:
+    """Map an existing segment without taking ownership of it.
+
+    Before Python 3.13, attaching also registers the segment with this process's resource
+    tracker, which unlinks it (and warns of a leak) when the process exits, pulling the
+    ring out from under its owner. Only the ring that created a segment may unlink it.
+    """
+    if sys.version_info >= (3, 13):
+        return shared_memory.SharedMemory(name=name, track=False)
+    shm = shared_memory.SharedMemory(name=name)
+    resource_tracker.unregister(shm._name, 'shared_memory')
+    return shm
+
+
+def _close_quietly(shm: shared_memory.SharedMemory) -> None:
+    try:
+        shm.close()
+    except BufferError:  # caller still holds frame views; the mapping lives until they go
+        pass
+
+
+class FrameSlabRing:
+    """A fixed ring of ``slots`` frame slabs of ``slot_bytes`` each, owned by the parent.
+
+    Slot bookkeeping (:meth:`acquire` / :meth:`release`) is done by the owning process
+    only, from any of its threads; workers just write into the slot they were handed.
+    """
+
+    def __init__(self, slots: int = 4, slot_bytes: int = DEFAULT_SLOT_BYTES):
+        if slots < 1 or slot_bytes < 1:
+            raise ValueError('slots and slot_bytes must be positive')
+        self.slots = slots
+        self.slot_bytes = slot_bytes
+        self._shm = shared_memory.SharedMemory(create=True, size=slots * slot_bytes)
+        self._free = deque(range(slots))
+        self._lock = threading.Lock()
+
+    @property
+    def name(self) -> str:
+        return self._shm.name
+
+    def acquire(self) -> Optional[int]:
+        """Take a free slot, or ``None`` when every slot is in use."""
+        with self._lock:
+            return self._free.popleft() if self._free else None
+
+    def release(self, item) -> None:
+        """Return a slot to the ring; accepts a slot number or any decode result."""
+        if isinstance(item, FrameDescriptor):
+            item = item.slot
+        with self._lock:
+            if isinstance(item, int) and item not in self._free:
+                self._free.append(item)
+
+    def view(self, item) -> Optional[PixelBean]:
+        """A :class:`PixelBean` for a decode result; descriptor frames are zero-copy views
+        that stay valid until the slot is released."""
+        if not isinstance(item, FrameDescriptor):
+            return item
+        return _bean_from_frames(item, _frames_view(self._shm.buf, item))
+
+    def close(self) -> None:
+        _close_quietly(self._shm)
+        if sys.version_info < (3, 13):
+            # Pool workers share our tracker, so their _attach() dropped our registration
+            # too; restore it so unlink()'s own unregister finds it (a no-op otherwise).
+            resource_tracker.register(self._shm._name, 'shared_memory')
+        self._shm.unlink()
+
+    def __enter__(self) -> 'FrameSlabRing':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+@contextmanager
+def attach_bean(desc: FrameDescriptor) -> Iterator[PixelBean]:
+    """Map a descriptor's slab in any process (e.g. an encoder) and yield a zero-copy bean."""
+    shm = _attach(desc.shm_name)
+    try:
+        yield _bean_from_frames(desc, _frames_view(shm.buf, desc))
+    finally:
+        _close_quietly(shm)
+
+
+def decode_into_slab(file_path: str, shm_name: str, slot: int,
+                     slot_bytes: int) -> Union[FrameDescriptor, PixelBean, None]:
+    """Worker entry point: decode ``file_path`` and write its frames into ``slot``.
+
+    Returns the descriptor, or the bean itself when it is larger than a slot.
+    """
+    return _into_slab(PixelBeanDecoder.decode_file(file_path), file_path, shm_name, slot,
+                      slot_bytes)
+
+
+def decode_bytes_into_slab(data: bytes, shm_name: str, slot: int,
+                           slot_bytes: int) -> Union[FrameDescriptor, PixelBean, None]:
+    """:func:`decode_into_slab` for a file the caller has already read."""
+    return _into_slab(PixelBeanDecoder.decode_stream(io.BytesIO(data)), '<bytes>', shm_name,
+                      slot, slot_bytes)
+
+
+def _into_slab(bean: Optional[PixelBean], source: str, shm_name: str, slot: int,
+               slot_bytes: int) -> Union[FrameDescriptor, PixelBean, None]:
+    if bean is None or not bean.total_frames:
+        return bean
+    height, width = bean.frames_data[0].shape[:2]
+    desc = FrameDescriptor(shm_name, slot, slot * slot_bytes, bean.total_frames, height,
+                           width, bean.speed, bean.row_count, bean.column_count)
+    if desc.nbytes > slot_bytes:
+        log.info('%s needs %d bytes (slot holds %d); returning it by value',
+                 source, desc.nbytes, slot_bytes)
+        return bean
+    shm = _attach(shm_name)
+    try:
+        out = _frames_view(shm.buf, desc)
+        for i, frame in enumerate(bean.frames_data):
+            out[i] = frame
+        del out
+    finally:
+        shm.close()
+    return desc
+
+
+def decode_files_shared(paths: Iterable, executor, ring: FrameSlabRing
+                        ) -> Iterator[Tuple[object, Union[FrameDescriptor, PixelBean, None]]]:
+    """Decode ``paths`` on ``executor`` through ``ring``, yielding ``(path, item)`` in order.
+
+    At most ``ring.slots`` files are in flight, so memory stays bounded. The consumer owns
+    each descriptor's slot until it calls ``ring.release(item)``; holding every slot while
+    files remain raises ``RuntimeError``.
+    """
+    remaining = deque(paths)
+    pending = deque()
+
+    def fill():
+        while remaining:
+            slot = ring.acquire()
+            if slot is None:
+                return
+            path = remaining.popleft()
+            future = executor.submit(decode_into_slab, str(path), ring.name, slot,
+                                     ring.slot_bytes)
+            pending.append((path, slot, future))
+
+    fill()
+    while pending:
+        path, slot, future = pending.popleft()
+        try:
+            item = future.result()
+        except Exception:
+            ring.release(slot)
+            raise
+        if not isinstance(item, FrameDescriptor):
+            ring.release(slot)
+        yield path, item
+        fill()
+        if remaining and not pending:
+            raise RuntimeError('All frame slabs are held; release() results before continuing')
@@ -5,35 +5,90 @@ Two things live here so the client doesn't have to repeat them a dozen times:
 * :class:`DivoomSession` — one place that builds URLs, sets headers/timeout, retries on
   transient network errors, and parses JSON.
 * :func:`paginate` — the single ``StartNum``/``EndNum`` loop every listing endpoint uses.
+  With ``concurrency`` > 1 it keeps that many windows in flight and yields them in order
+  through a reorder buffer, so long crawls are bound by server concurrency instead of
+  round-trip time. :func:`estimate_total` finds a listing's length with a few probes.
+  With a :class:`BatchTuner` the window size adapts per endpoint and is remembered
+  across runs.
 """
 
 from __future__ import annotations
 
+import json
+import os
+import threading
 import time
-from typing import Callable, Dict, Iterable, Iterator, List, Optional, Sequence
+from collections import deque
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Callable, Dict, Iterable, Iterator, List, Optional, Sequence, Tuple, Union
 
 import requests
 
 from .config import DEFAULT_SETTINGS, Settings
-from .const import Server
+from .const import ApiEndpoint, Server
 from .logging import get_logger
+from .response_cache import ResponseCache, Singleflight, cache_key
 
 log = get_logger(__name__)
 
 
+class RateLimiter:
+    """Thread-safe token bucket: at most ``rate`` acquisitions per second, bursts of ``burst``."""
+
+    def __init__(self, rate: float, burst: Optional[int] = None):
+        self.rate = rate
+        self.burst = burst if burst is not None else max(1, int(rate))
+        self._tokens = float(self.burst)
+        self._stamp = time.monotonic()
+        self._lock = threading.Lock()
+
+    def acquire(self) -> None:
+        with self._lock:
+            now = time.monotonic()
+            self._tokens = min(self.burst, self._tokens + (now - self._stamp) * self.rate)
+            self._stamp = now
+            self._tokens -= 1  # reserve now; a negative balance is the wait
+            wait = -self._tokens / self.rate if self._tokens < 0 else 0.0
+        if wait:
+            time.sleep(wait)
+
+
 class DivoomSession:
-    """Thin wrapper over ``requests.Session`` for the Divoom JSON API."""
+    """Thin wrapper over ``requests.Session`` for the Divoom JSON API.
+
+    Every API request (from any thread) passes through one shared :class:`RateLimiter`
+    when ``settings.requests_per_second`` is set. Concurrent identical requests are
+    coalesced into one call, and with ``settings.response_cache_path`` responses of
+    endpoints with a TTL are served from a
+    :class:`~servoom.response_cache.ResponseCache`.
+    """
 
     def __init__(self, settings: Settings = DEFAULT_SETTINGS):
         self._settings = settings
         self._session = requests.Session()
         self._session.headers.update(settings.headers)
+        pool = max(settings.page_concurrency, settings.fetch_workers)
+        if pool > 10:  # requests' default pool holds 10 connections
+            adapter = requests.adapters.HTTPAdapter(pool_maxsize=pool)
+            self._session.mount("https://", adapter)
+            self._session.mount("http://", adapter)
+        rps = settings.requests_per_second
+        self.limiter = RateLimiter(rps) if rps else None
+        self._flight = Singleflight()
+        self.cache = ResponseCache(settings.response_cache_path,
+                                   settings.response_cache_ttls) \
+            if settings.response_cache_path else None
 
-    @staticmethod
-    def url(path: str, server: Server = Server.API) -> str:
+    def url(self, path: str, server: Server = Server.API) -> str:
         if not path.startswith("/"):
             path = "/" + path
-        return f"https://{server.value}{path}"
+        base = self._settings.api_base if server == Server.API else self._settings.file_base
+        return f"{(base or f'https://{server.value}').rstrip('/')}{path}"
+
+    def file_url(self, file_id: str) -> str:
+        """Download URL for an artwork's ``FileId``."""
+        return self.url(file_id, Server.FILE)
 
     def post_json(self, path: str, payload: Optional[Dict] = None) -> Dict:
         """POST ``payload`` as JSON and return the parsed response.
@@ -42,9 +97,32 @@ class DivoomSession:
         ``requests.RequestException`` if every attempt fails, or ``ValueError`` if the
         final response body is not JSON.
         """
+        if path == ApiEndpoint.USER_LOGIN.value:
+            return self._post(path, payload)
+        key = cache_key(path, payload)
+        if self.cache is not None and self.cache.ttl_for(path) > 0:
+            cached = self.cache.get(key, path)
+            if cached is not None:
+                return cached
+            return self._flight.do(key, lambda: self._post_and_store(key, path, payload))
+        return self._flight.do(key, lambda: self._post(path, payload))
+
+    def _post_and_store(self, key: str, path: str, payload: Optional[Dict]) -> Dict:
+        response = self._post(path, payload)
+        self.cache.put(key, path, response)
+        return response
+
+    def metrics(self) -> Dict[str, int]:
+        """Response-cache hits/misses/expired/stores and coalesced requests."""
+        stats = self.cache.metrics() if self.cache is not None else {}
+        return {**stats, "coalesced": self._flight.coalesced}
+
+    def _post(self, path: str, payload: Optional[Dict]) -> Dict:
         url = self.url(path)
         last_exc: Optional[Exception] = None
         for attempt in range(self._settings.max_retries):
+            if self.limiter is not None:
+                self.limiter.acquire()
             try:
                 resp = self._session.post(
                     url, json=payload or {}, timeout=self._settings.request_timeout
@@ -69,6 +147,131 @@ def _first_nonempty_list(data: Dict, keys: Sequence[str]) -> List[Dict]:
     return []
 
 
+def _request_window(
+    post: Callable[[str, Dict], Dict],
+    path: str,
+    base_payload: Dict,
+    start: int,
+    size: int,
+    list_keys: Sequence[str],
+) -> Tuple[List[Dict], Optional[int]]:
+    """``(items, ReturnCode)`` of one window; the code is ``None`` for a non-JSON body."""
+    payload = {**base_payload, "StartNum": start, "EndNum": start + size - 1}
+    try:
+        data = post(path, payload)
+    except ValueError:
+        log.warning("Non-JSON response for %s at StartNum=%d", path, start)
+        return [], None
+    code = data.get("ReturnCode", 0)
+    return (_first_nonempty_list(data, list_keys) if code == 0 else []), code
+
+
+def _fetch_window(
+    post: Callable[[str, Dict], Dict],
+    path: str,
+    base_payload: Dict,
+    start: int,
+    size: int,
+    list_keys: Sequence[str],
+) -> List[Dict]:
+    """Items of one ``StartNum``/``EndNum`` window; ``[]`` means "stop here"."""
+    items, code = _request_window(post, path, base_payload, start, size, list_keys)
+    if code:
+        log.warning("Stopping %s at StartNum=%d: ReturnCode=%s; the listing is incomplete",
+                    path, start, code)
+    return items
+
+
+def default_tuner_path() -> Path:
+    return Path.home() / ".cache" / "servoom" / "batch_sizes.json"
+
+
+class BatchTuner:
+    """Per-endpoint adaptive ``batch_size``, persisted as JSON between runs.
+
+    Grows the window by ``grow`` while pages come back full in under ``fast_s``, halves it
+    on a response slower than ``slow_s`` or a throttling ``ReturnCode``, and clamps it to
+    the page size the server actually returns (a short page followed by more items means
+    the server caps pages). Sizes stay within ``[min_size, max_size]``.
+    """
+
+    def __init__(
+        self,
+        initial: int = 40,
+        *,
+        min_size: int = 5,
+        max_size: int = 200,
+        fast_s: float = 0.5,
+        slow_s: float = 2.0,
+        grow: float = 1.5,
+        backoff_s: float = 0.5,
+        path: Union[str, Path, None] = None,
+    ):
+        self.initial = initial
+        self.min_size = min_size
+        self.max_size = max_size
+        self.fast_s = fast_s
+        self.slow_s = slow_s
+        self.grow = grow
+        self.backoff_s = backoff_s  # first pause after a throttled window; doubles
+        self.path = Path(path) if path is not None else None
+        self._lock = threading.Lock()
+        self._state: Dict[str, Dict[str, int]] = {}  # endpoint -> {"size", "cap"}
+        if self.path is not None and self.path.exists():
+            try:
+                self._state = json.loads(self.path.read_text("utf-8"))
+            except ValueError:
+                log.warning("Ignoring unreadable batch-size state in %s", self.path)
+
+    def _clamp(self, endpoint: str, size: float) -> int:
+        cap = self._state.get(endpoint, {}).get("cap") or self.max_size
+        return int(max(self.min_size, min(size, cap, self.max_size)))
+
+    def size_for(self, endpoint: str) -> int:
+        with self._lock:
+            state = self._state.get(endpoint, {})
+            return self._clamp(endpoint, state.get("size", self.initial))
+
+    def _set(self, endpoint: str, size: float) -> None:
+        state = self._state.setdefault(endpoint, {})
+        state["size"] = self._clamp(endpoint, size)
+
+    def observe(self, endpoint: str, requested: int, received: int, elapsed: float) -> None:
+        """A page answered in ``elapsed`` seconds (short pages are judged by the next one)."""
+        with self._lock:
+            if elapsed > self.slow_s:
+                self._set(endpoint, requested / 2)
+                log.debug("%s slow (%.2f s): batch_size -> %d", endpoint, elapsed,
+                          self._state[endpoint]["size"])
+            elif received >= requested and elapsed < self.fast_s:
+                self._set(endpoint, max(requested + 1, requested * self.grow))
+
+    def truncated(self, endpoint: str, page_len: int) -> None:
+        """The server returned ``page_len`` items although more followed: it caps pages."""
+        with self._lock:
+            state = self._state.setdefault(endpoint, {})
+            cap = max(self.min_size, page_len)
+            if state.get("cap") != cap:
+                log.info("%s caps pages at %d items", endpoint, page_len)
+            state["cap"] = cap
+            self._set(endpoint, page_len)
+
+    def throttled(self, endpoint: str, requested: int) -> None:
+        with self._lock:
+            self._set(endpoint, requested / 2)
+            log.info("%s throttled: batch_size -> %d", endpoint, self._state[endpoint]["size"])
+
+    def save(self) -> None:
+        if self.path is None:
+            return
+        with self._lock:
+            data = json.dumps(self._state, indent=1, sort_keys=True)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = self.path.with_suffix(f".{os.getpid()}.tmp")
+        tmp.write_text(data, "utf-8")
+        tmp.replace(self.path)
+
+
 def paginate(
     post: Callable[[str, Dict], Dict],
     path: str,
@@ -79,11 +282,16 @@ def paginate(
     keep: Optional[Callable[[Dict], bool]] = None,
     limit: Optional[int] = None,
     on_page: Optional[Callable[[int, int], None]] = None,
+    concurrency: int = 1,
+    total: Optional[int] = None,
+    tuner: Optional[BatchTuner] = None,
+    throttle_codes: Sequence[int] = DEFAULT_SETTINGS.throttle_codes,
 ) -> Iterator[Dict]:
     """Yield items across paginated ``StartNum``/``EndNum`` requests.
 
     Args:
-        post: callable like :meth:`DivoomSession.post_json`.
+        post: callable like :meth:`DivoomSession.post_json` (thread-safe if
+            ``concurrency`` > 1).
         path: endpoint path.
         base_payload: fields common to every page (auth, filters, keywords, ...).
         batch_size: window size per request.
@@ -91,35 +299,156 @@ def paginate(
         keep: predicate; items for which it returns ``False`` are skipped.
         limit: stop after yielding this many items (``None`` = no limit).
         on_page: optional ``(start, running_total)`` progress callback.
+        concurrency: windows requested at once. Results are still yielded strictly in
+            window order; at most ``concurrency - 1`` requests are wasted past the end.
+        total: known (or :func:`estimate_total`-ed) item count; no window starting past
+            it is requested.
+        tuner: adapt the window size per request (``batch_size`` is then ignored). A
+            sequential crawl also advances by the items actually returned, so capped
+            pages lose nothing, and it retries throttled windows with smaller sizes. With
+            ``concurrency`` > 1 the tuner only supplies its remembered size.
+        throttle_codes: ReturnCodes the tuned crawl backs off and retries on (down to the
+            tuner's ``min_size``, then a few more times); any other error code ends it at
+            once.
 
     Stops on: an error ``ReturnCode``, a page with no items, a non-JSON body, or ``limit``.
+    Stopping on an error code (or giving up on throttling) is logged as a warning with the
+    ``StartNum`` reached, since the items yielded so far are then only part of the listing.
+    Pages after the stopping one are discarded, even if they already arrived.
     """
     keep = keep or (lambda _item: True)
-    start = 1
-    collected = 0
-    while True:
-        payload = {**base_payload, "StartNum": start, "EndNum": start + batch_size - 1}
-        try:
-            data = post(path, payload)
-        except ValueError:
-            log.warning("Non-JSON response for %s at StartNum=%d", path, start)
-            return
-        if data.get("ReturnCode", 0) != 0:
-            log.debug("Stopping %s: ReturnCode=%s", path, data.get("ReturnCode"))
+    concurrency = max(1, concurrency)
+    if tuner is not None:
+        if concurrency == 1:
+            yield from _paginate_tuned(post, path, base_payload, tuner, list_keys, keep,
+                                       limit, on_page, total, throttle_codes)
             return
-        items = _first_nonempty_list(data, list_keys)
-        if not items:
+        batch_size = tuner.size_for(path)
+    starts = iter(range(1, (total if total is not None else 1 << 62) + 1, batch_size))
+    pool = ThreadPoolExecutor(concurrency) if concurrency > 1 else None
+    pending: deque = deque()  # reorder buffer: (start, future/result) in window order
+
+    def request_next() -> None:
+        start = next(starts, None)
+        if start is None:
             return
-        for item in items:
-            if not keep(item):
+        args = (post, path, base_payload, start, batch_size, list_keys)
+        pending.append((start, pool.submit(_fetch_window, *args) if pool else args))
+
+    for _ in range(concurrency):
+        request_next()
+    collected = 0
+    try:
+        while pending:
+            start, job = pending.popleft()
+            items = job.result() if pool else _fetch_window(*job)
+            if not items:
+                return
+            request_next()  # keep ``concurrency`` windows in flight
+            for item in items:
+                if not keep(item):
+                    continue
+                yield item
+                collected += 1
+                if limit is not None and collected >= limit:
+                    return
+            if on_page:
+                on_page(start, collected)
+    finally:
+        if pool is not None:
+            pool.shutdown(wait=False, cancel_futures=True)
+
+
+def _paginate_tuned(post, path, base_payload, tuner: BatchTuner, list_keys, keep, limit,
+                    on_page, total, throttle_codes: Sequence[int],
+                    max_throttles: int = 3) -> Iterator[Dict]:
+    # A throttled window is retried at half the size; once at ``tuner.min_size`` it is
+    # retried ``max_throttles`` more times (pauses doubling up to 8 s) before giving up.
+    start = 1
+    collected = 0
+    throttles = 0  # in a row
+    floor_retries = 0  # of those, at tuner.min_size
+    short_page = 0  # length of the previous page if it came back short
+    save = True
+    try:
+        while total is None or start <= total:
+            size = tuner.size_for(path)
+            began = time.monotonic()
+            items, code = _request_window(post, path, base_payload, start, size, list_keys)
+            elapsed = time.monotonic() - began
+            if code and code not in throttle_codes:
+                # An API error says nothing about the window size: leave the tuner as is
+                log.warning("Stopping %s at StartNum=%d: ReturnCode=%s; the listing is "
+                            "incomplete", path, start, code)
+                save = False
+                return
+            if code:
+                throttles += 1
+                if size <= tuner.min_size:
+                    floor_retries += 1
+                    if floor_retries > max_throttles:
+                        log.warning("Giving up on %s at StartNum=%d after %d throttled "
+                                    "requests (ReturnCode=%s); the listing is incomplete",
+                                    path, start, throttles, code)
+                        return
+                else:
+                    tuner.throttled(path, size)
+                time.sleep(min(tuner.backoff_s * 2 ** (throttles - 1), 8.0))
                 continue
-            yield item
-            collected += 1
-            if limit is not None and collected >= limit:
+            throttles = floor_retries = 0
+            if not items:
                 return
-        if on_page:
-            on_page(start, collected)
-        start += batch_size
+            if short_page:
+                tuner.truncated(path, short_page)
+            tuner.observe(path, size, len(items), elapsed)
+            for item in items:
+                if not keep(item):
+                    continue
+                yield item
+                collected += 1
+                if limit is not None and collected >= limit:
+                    return
+            if on_page:
+                on_page(start, collected)
+            short_page = len(items) if len(items) < size else 0
+            start += len(items)
+    finally:
+        if save:
+            tuner.save()
+
+
+def estimate_total(
+    post: Callable[[str, Dict], Dict],
+    path: str,
+    base_payload: Dict,
+    *,
+    list_keys: Sequence[str] = ("FileList",),
+    max_total: int = 1 << 24,
+) -> int:
+    """Number of items a listing holds, found with one-item probe windows.
+
+    Probes ``StartNum`` 1, 2, 4, 8, ... until a window comes back empty, then binary
+    searches between the last hit and the first miss: about ``2 * log2(total)`` requests.
+    Counts raw positions (before any ``keep`` filter). Pass the result as
+    ``paginate(..., total=...)``.
+    """
+    def has(position: int) -> bool:
+        return bool(_fetch_window(post, path, base_payload, position, 1, list_keys))
+
+    if not has(1):
+        return 0
+    low, high = 1, 2  # has(low) is true; high is probed next
+    while high <= max_total and has(high):
+        low, high = high, high * 2
+    if high > max_total:
+        return max_total
+    while high - low > 1:  # invariant: has(low), not has(high)
+        mid = (low + high) // 2
+        if has(mid):
+            low = mid
+        else:
+            high = mid
+    return low
 
 
 def collect(items: Iterable[Dict]) -> List[Dict]:
@@ -0,0 +1,73 @@
+"""Local cache of gallery metadata (``Cloud/GalleryInfo`` responses) keyed by GalleryId.
+
+:meth:`DivoomClient.fetch_artwork_infos` serves hits from it and stores every fetched
+record. It is one SQLite file (stdlib, safe to share between threads), so a 100k-entry
+catalogue reloads instantly. ``max_age`` turns it into a refresh tool: records older than
+that are re-fetched, e.g. to update ``LikeCnt``/``WatchCnt`` once a day.
+"""
+
+from __future__ import annotations
+
+import json
+import sqlite3
+import threading
+import time
+from pathlib import Path
+from typing import Dict, Iterable, Optional, Union
+
+from .logging import get_logger
+
+log = get_logger(__name__)
+
+
+class MetadataCache:
+    """``GalleryId -> metadata dict`` with a fetch timestamp per record."""
+
+    def __init__(self, path: Union[str, Path]):
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._db = sqlite3.connect(str(self.path), check_same_thread=False)
+        self._lock = threading.Lock()
+        with self._lock, self._db:
+            self._db.execute('PRAGMA journal_mode=WAL')
+            self._db.execute('CREATE TABLE IF NOT EXISTS gallery ('
+                             'gallery_id INTEGER PRIMARY KEY, fetched REAL, record TEXT)')
+
+    def __len__(self) -> int:
+        with self._lock:
+            return self._db.execute('SELECT COUNT(*) FROM gallery').fetchone()[0]
+
+    def get_many(self, gallery_ids: Iterable[int],
+                 max_age: Optional[float] = None) -> Dict[int, Dict]:
+        """Cached records for ``gallery_ids`` (those fetched within ``max_age`` seconds)."""
+        ids = list(gallery_ids)
+        oldest = time.time() - max_age if max_age is not None else float('-inf')
+        found: Dict[int, Dict] = {}
+        with self._lock:
+            for i in range(0, len(ids), 500):  # stay under SQLite's bound-parameter limit
+                chunk = ids[i:i + 500]
+                rows = self._db.execute(
+                    f'SELECT gallery_id, fetched, record FROM gallery '
+                    f'WHERE gallery_id IN ({",".join("?" * len(chunk))})', chunk)
+                for gallery_id, fetched, record in rows:
+                    if fetched >= oldest:
+                        found[gallery_id] = json.loads(record)
+        return found
+
+    def get(self, gallery_id: int, max_age: Optional[float] = None) -> Optional[Dict]:
+        return self.get_many([gallery_id], max_age).get(gallery_id)
+
+    def put(self, gallery_id: int, record: Dict) -> None:
+        with self._lock, self._db:
+            self._db.execute('INSERT OR REPLACE INTO gallery VALUES (?, ?, ?)',
+                             (gallery_id, time.time(), json.dumps(record)))
+
+    def close(self) -> None:
+        with self._lock:
+            self._db.close()
+
+    def __enter__(self) -> 'MetadataCache':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
@@ -0,0 +1,332 @@
+"""Local stand-in for the Divoom cloud, for reproducible throughput and load testing.
+
+:class:`MockDivoomServer` implements the endpoints in :class:`~servoom.const.ApiEndpoint`
+and the ``Server.FILE`` download host on one local HTTP port. It serves a synthetic
+catalogue of gallery records and decodable format-42 ``.dat`` payloads (zstd raw RGB).
+:class:`MockConfig` sets the network behaviour:
+
+* ``latency``/``jitter`` — seconds added to every response
+* ``page_cap`` — most items a listing returns per page, whatever ``EndNum`` asks for
+* ``throttle_rps``/``throttle_rate`` — answer ``{"ReturnCode": throttle_code}`` above a
+  request rate, or for a random fraction of API calls (login is never throttled)
+* ``failure_rate`` — fraction of requests answered with a non-JSON HTTP 503
+* ``bandwidth`` — bytes/s cap per file download
+
+Point a client at it through :class:`~servoom.config.Settings` (``server.settings()``).
+:func:`run_benchmark` times a crawl (items/s) and downloads (MB/s) for a given client
+configuration. Everything is deterministic for a given ``seed``.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import random
+import struct
+import tempfile
+import threading
+import time
+from dataclasses import dataclass, field, replace
+from functools import lru_cache
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Dict, List, Optional
+
+import numpy as np
+
+from .config import DEFAULT_SETTINGS, Settings
+from .const import ApiEndpoint
+from .logging import get_logger
+
+log = get_logger(__name__)
+
+_LISTINGS = {
+    ApiEndpoint.GET_MY_UPLOADS.value, ApiEndpoint.GET_SOMEONE_LIST.value,
+    ApiEndpoint.GET_CATEGORY_FILES.value, ApiEndpoint.GET_TAG_GALLERY.value,
+    ApiEndpoint.SEARCH_GALLERY.value,
+}
+_FILES = '/files/'
+_GALLERY_BASE = 1_000_000
+
+
+@dataclass(frozen=True)
+class MockConfig:
+    """Catalogue size and network behaviour of a :class:`MockDivoomServer`."""
+
+    items: int = 1000
+    users: int = 50
+    frames: int = 8
+    grid: int = 1  # row/column count: 1 = 16x16, 2 = 32x32, ...
+    hidden_rate: float = 0.05  # records with HideFlag set
+    remix_rate: float = 0.1  # records with an OriginalGalleryId
+    page_cap: Optional[int] = None
+    latency: float = 0.0
+    jitter: float = 0.0
+    throttle_rps: Optional[float] = None
+    throttle_rate: float = 0.0
+    throttle_code: int = 10
+    failure_rate: float = 0.0
+    bandwidth: Optional[float] = None
+    seed: int = 0
+
+
+@dataclass
+class MockStats:
+    requests: int = 0
+    throttled: int = 0
+    failed: int = 0
+    files: int = 0
+    bytes_sent: int = 0
+    by_path: Dict[str, int] = field(default_factory=dict)
+
+
+class _Catalogue:
+    """Deterministic synthetic records and ``.dat`` payloads."""
+
+    def __init__(self, config: MockConfig):
+        self.config = config
+        rng = random.Random(config.seed)
+        self.records = []
+        for i in range(config.items):
+            gallery_id = _GALLERY_BASE + i
+            record = {
+                'GalleryId': gallery_id, 'FileId': f'group1/M00/mock/{i:08d}',
+                'FileName': f'mock art {i}', 'FileType': 5, 'Classify': i % 20,
+                'UserId': 100 + rng.randrange(config.users), 'UserName': f'user{i % 97}',
+                'LikeCnt': rng.randrange(1000), 'CommentCnt': rng.randrange(50),
+                'WatchCnt': rng.randrange(10000), 'ShareCnt': rng.randrange(20),
+                'Date': 1_700_000_000 + i * 60, 'FileTagArray': [f'tag{i % 7}'],
+                'HideFlag': int(rng.random() < config.hidden_rate),
+            }
+            if i and rng.random() < config.remix_rate:
+                record['OriginalGalleryId'] = _GALLERY_BASE + rng.randrange(i)
+            self.records.append(record)
+        self.users = [{'UserId': 100 + u, 'NickName': f'user{u}', 'Fans': u * 3}
+                      for u in range(config.users)]
+
+    def record(self, gallery_id) -> Optional[Dict]:
+        try:
+            i = int(gallery_id) - _GALLERY_BASE
+        except (TypeError, ValueError):
+            return None
+        return self.records[i] if 0 <= i < len(self.records) else None
+
+    @lru_cache(maxsize=4096)
+    def payload(self, file_id: str) -> Optional[bytes]:
+        import zstandard
+
+        try:
+            i = int(file_id.rsplit('/', 1)[-1])
+        except ValueError:
+            return None
+        if not 0 <= i < len(self.records):
+            return None
+        c = self.config
+        side = 16 * c.grid
+        rng = np.random.default_rng((c.seed, i))
+        frames = rng.integers(0, 256, (c.frames, side, side, 3), dtype=np.uint8)
+        header = bytes([42]) + struct.pack('>BHBB', c.frames, 100, c.grid, c.grid)
+        return header + zstandard.ZstdCompressor(level=1).compress(frames.tobytes())
+
+
+class _Handler(BaseHTTPRequestHandler):
+    server: '_HTTPServer'
+    protocol_version = 'HTTP/1.1'  # keep-alive, like the real hosts
+    disable_nagle_algorithm = True  # headers and body go out as separate writes
+
+    def log_message(self, fmt, *args) -> None:
+        log.debug('mock: ' + fmt, *args)
+
+    def _send(self, status: int, body: bytes, content_type: str) -> None:
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        bandwidth = self.server.mock.config.bandwidth
+        step = 64 << 10
+        for pos in range(0, len(body), step):
+            chunk = body[pos:pos + step]
+            self.wfile.write(chunk)
+            if bandwidth:
+                time.sleep(len(chunk) / bandwidth)
+        self.server.mock.count(bytes_sent=len(body))
+
+    def _json(self, data: Dict) -> None:
+        self._send(200, json.dumps(data).encode(), 'application/json')
+
+    def do_POST(self) -> None:
+        mock = self.server.mock
+        body = self.rfile.read(int(self.headers.get('Content-Length') or 0))
+        if mock.before_request(self.path):
+            self._send(503, b'Service Unavailable', 'text/plain')
+            return
+        if self.path != ApiEndpoint.USER_LOGIN.value and mock.throttled():
+            self._json({'ReturnCode': mock.config.throttle_code,
+                        'ReturnMessage': 'Request too frequent'})
+            return
+        try:
+            payload = json.loads(body or b'{}')
+        except ValueError:
+            payload = {}
+        response = mock.api(self.path, payload)
+        if response is None:
+            self._send(404, b'Not Found', 'text/plain')
+        else:
+            self._json(response)
+
+    def do_GET(self) -> None:
+        mock = self.server.mock
+        if mock.before_request(self.path):
+            self._send(503, b'Service Unavailable', 'text/plain')
+            return
+        data = mock.catalogue.payload(self.path[len(_FILES):]) \
+            if self.path.startswith(_FILES) else None
+        if data is None:
+            self._send(404, b'Not Found', 'text/plain')
+            return
+        mock.count(files=1)
+        self._send(200, data, 'application/octet-stream')
+
+
+class _HTTPServer(ThreadingHTTPServer):
+    daemon_threads = True
+    mock: 'MockDivoomServer'
+
+
+class MockDivoomServer:
+    """Threaded local server; use as a context manager or call :meth:`start`/:meth:`stop`."""
+
+    def __init__(self, config: MockConfig = MockConfig(), host: str = '127.0.0.1',
+                 port: int = 0):
+        self.config = config
+        self.catalogue = _Catalogue(config)
+        self.stats = MockStats()
+        self._lock = threading.Lock()
+        self._rng = random.Random(config.seed + 1)
+        self._window: List[float] = []  # request times in the last second (throttle_rps)
+        self._httpd = _HTTPServer((host, port), _Handler)
+        self._httpd.mock = self
+        self._thread: Optional[threading.Thread] = None
+
+    @property
+    def url(self) -> str:
+        host, port = self._httpd.server_address[:2]
+        return f'http://{host}:{port}'
+
+    def settings(self, base: Settings = DEFAULT_SETTINGS, **overrides) -> Settings:
+        """``base`` pointed at this server (plus any ``Settings`` field overrides)."""
+        overrides.setdefault('throttle_codes', (self.config.throttle_code,))
+        return replace(base, api_base=self.url, file_base=self.url + _FILES.rstrip('/'),
+                       retry_delay=0, **overrides)
+
+    # -- request accounting ---------------------------------------------------------
+    def count(self, **deltas) -> None:
+        with self._lock:
+            for name, delta in deltas.items():
+                setattr(self.stats, name, getattr(self.stats, name) + delta)
+
+    def before_request(self, path: str) -> bool:
+        """Apply latency and count the request; ``True`` if it should fail with a 503."""
+        c = self.config
+        with self._lock:
+            self.stats.requests += 1
+            self.stats.by_path[path] = self.stats.by_path.get(path, 0) + 1
+            fail = self._rng.random() < c.failure_rate
+            delay = c.latency + (self._rng.uniform(0, c.jitter) if c.jitter else 0.0)
+            if fail:
+                self.stats.failed += 1
+        if delay:
+            time.sleep(delay)
+        return fail
+
+    def throttled(self) -> bool:
+        c = self.config
+        with self._lock:
+            now = time.monotonic()
+            self._window = [t for t in self._window if now - t < 1.0]
+            self._window.append(now)
+            over = c.throttle_rps is not None and len(self._window) > c.throttle_rps
+            if over or self._rng.random() < c.throttle_rate:
+                self.stats.throttled += 1
+                return True
+        return False
+
+    # -- endpoints --------------------------------------------------------------------
+    def api(self, path: str, payload: Dict) -> Optional[Dict]:
+        ok = {'ReturnCode': 0, 'ReturnMessage': ''}
+        if path == ApiEndpoint.USER_LOGIN.value:
+            return {**ok, 'UserId': 1, 'Token': 'mock-token'}
+        if path == ApiEndpoint.GET_GALLERY_INFO.value:
+            record = self.catalogue.record(payload.get('GalleryId'))
+            return {**ok, **record} if record else {'ReturnCode': 1, 'ReturnMessage': 'none'}
+        if path in _LISTINGS:
+            return {**ok, 'FileList': self._page(self.catalogue.records, payload)}
+        if path in (ApiEndpoint.GET_LIKE_USERS.value, ApiEndpoint.SEARCH_USER.value):
+            return {**ok, 'UserList': self._page(self.catalogue.users, payload)}
+        if path == ApiEndpoint.GET_SOMEONE_INFO.value:
+            return {**ok, 'UserId': payload.get('SomeOneUserId'), 'NickName': 'mock user'}
+        if path == ApiEndpoint.SEARCH_TAG.value:
+            return {**ok, 'TagList': [{'TagName': f'tag{t}'} for t in range(7)]}
+        if path == ApiEndpoint.GET_TAG_INFO.value:
+            return {**ok, 'TagName': payload.get('TagName'),
+                    'GalleryCnt': len(self.catalogue.records)}
+        return None
+
+    def _page(self, items: List[Dict], payload: Dict) -> List[Dict]:
+        start = max(int(payload.get('StartNum', 1)), 1)
+        end = int(payload.get('EndNum', start + 29))
+        if self.config.page_cap is not None:
+            end = min(end, start + self.config.page_cap - 1)
+        return items[start - 1:end]
+
+    # -- lifecycle ----------------------------------------------------------------
+    def start(self) -> 'MockDivoomServer':
+        self._thread = threading.Thread(target=self._httpd.serve_forever, daemon=True,
+                                        name='mock-divoom')
+        self._thread.start()
+        log.info('Mock Divoom API listening on %s', self.url)
+        return self
+
+    def stop(self) -> None:
+        self._httpd.shutdown()
+        self._httpd.server_close()
+        if self._thread is not None:
+            self._thread.join()
+
+    def __enter__(self) -> 'MockDivoomServer':
+        return self.start()
+
+    def __exit__(self, *exc) -> None:
+        self.stop()
+
+
+def run_benchmark(settings: Settings, downloads: int = 100, limit: Optional[int] = None,
+                  store=None) -> dict:
+    """Time a crawl and ``downloads`` file downloads with a client built from ``settings``.
+
+    Returns ``{"crawl_items", "crawl_s", "items_per_s", "downloads", "download_bytes",
+    "download_s", "mb_per_s"}``. ``store`` (a ``PackStore``) receives the downloads;
+    otherwise they go to a temporary directory.
+    """
+    from .client import DivoomClient
+
+    client = DivoomClient(email='bench@localhost', md5_password='0' * 32, settings=settings)
+    if not client.login():
+        raise RuntimeError('Benchmark login failed')
+    started = time.perf_counter()
+    beans = client.fetch_someone_arts_as_beans(100, limit=limit)
+    crawl_s = time.perf_counter() - started
+
+    with tempfile.TemporaryDirectory(prefix='servoom-bench-') as tmp:
+        started = time.perf_counter()
+        paths = client._download_beans(beans[:downloads], tmp, store)
+        download_s = time.perf_counter() - started
+        if store is not None:
+            size = sum(len(store.get(b.file_id)) for b in beans[:downloads] if b.file_id in store)
+        else:
+            size = sum(os.path.getsize(p) for p in paths)
+    return {
+        'crawl_items': len(beans), 'crawl_s': crawl_s,
+        'items_per_s': len(beans) / crawl_s if crawl_s else 0.0,
+        'downloads': len(paths), 'download_bytes': size, 'download_s': download_s,
+        'mb_per_s': size / download_s / 1e6 if download_s else 0.0,
+    }
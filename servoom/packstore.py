@@ -0,0 +1,568 @@
+"""Append-only packfile store for raw ``.dat`` blobs.
+
+Millions of tiny downloads (a 16x16 format-9 file is often under 2 KB) make backups,
+rsync and directory scans crawl. A :class:`PackStore` appends blobs to a few large
+segment files and keeps an on-disk index mapping each key (normally the artwork's
+``FileId``) to its segment, offset, length and CRC-32::
+
+    store/
+      seg-00000.pack     records: header (magic, key length, data length, crc) + key + data
+      seg-00001.pack     a new segment starts after ``max_segment_bytes``
+      index.jsonl        one line per put/delete; the last line for a key wins
+
+Reads go through ``mmap``. :meth:`PackStore.get` returns a zero-copy ``memoryview`` of
+the blob, and :meth:`PackStore.open` wraps it in a reader that ``decode_stream``
+accepts. Overwritten and deleted blobs stay in their segments until :meth:`compact`
+rewrites only the live ones. Because segments are self-describing, the index can be
+rebuilt from them (:meth:`rebuild_index`).
+
+Archival mode (:meth:`PackStore.train_dictionaries`) trains one zstd dictionary per
+file format from the stored blobs. Later puts, and a :meth:`compact`, store each blob
+compressed with its format's dictionary. AES formats (9, 17, 18) are compressed as
+plaintext and re-encrypted on read. The fixed key and IV make that byte-exact, and every
+blob is checked before it is stored that way. Reads decompress transparently, so
+``get``/``decode`` behave the same, minus the zero-copy guarantee.
+
+One process writes at a time. Readers load the index when they open the store.
+"""
+
+from __future__ import annotations
+
+import csv
+import json
+import mmap
+import os
+import struct
+import time
+import zlib
+from pathlib import Path
+from typing import Dict, Iterator, List, NamedTuple, Optional, Union
+
+from Crypto.Cipher import AES
+
+from .csv_export import FIELD_MAPPINGS
+from .logging import get_logger
+from .pixel_bean import PixelBean
+from .pixel_bean_decoder import BaseDecoder, PixelBeanDecoder
+
+log = get_logger(__name__)
+
+_MAGIC = b'SVPK'
+_RECORD = struct.Struct('>4sHII')  # magic, key length, data length, crc32
+_MAGIC_Z = b'SVPZ'
+_RECORD_Z = struct.Struct('>4sHIIIB')  # ... + dictionary id (0 = none), flags
+_PLAINTEXT = 1  # flag: AES body stored decrypted; re-encrypt on read
+_AES_HEADER_LEN = {9: 4, 17: 7, 18: 6}  # format byte -> bytes before the ciphertext
+_INDEX = 'index.jsonl'
+_DICTS = 'dicts'
+DEFAULT_SEGMENT_BYTES = 256 << 20
+
+
+class PackEntry(NamedTuple):
+    segment: int
+    offset: int  # of the stored data (after the record header and key)
+    length: int  # stored length
+    crc: int  # of the original blob
+    dict_id: Optional[int] = None  # None: stored raw; else zstd (0 = no dictionary)
+    flags: int = 0
+
+    def to_record(self, key: str) -> dict:
+        rec = {'key': key, 'seg': self.segment, 'off': self.offset, 'len': self.length,
+               'crc': self.crc}
+        if self.dict_id is not None:
+            rec.update(dict=self.dict_id, flags=self.flags)
+        return rec
+
+
+def _aes(mode_encrypt: bool, data: bytes) -> bytes:
+    cipher = AES.new(BaseDecoder.AES_SECRET_KEY.encode('utf8'), AES.MODE_CBC, BaseDecoder.AES_IV)
+    return cipher.encrypt(data) if mode_encrypt else cipher.decrypt(data)
+
+
+def _to_plaintext(blob: bytes) -> Optional[bytes]:
+    """AES formats: the blob with its body decrypted, if re-encrypting restores it exactly."""
+    head = _AES_HEADER_LEN.get(blob[0]) if blob else None
+    if head is None or len(blob) <= head or (len(blob) - head) % 16:
+        return None
+    plain = blob[:head] + _aes(False, blob[head:])
+    return plain if _aes(True, plain[head:]) == blob[head:] else None
+
+
+def _from_plaintext(plain: bytes) -> bytes:
+    head = _AES_HEADER_LEN[plain[0]]
+    return plain[:head] + _aes(True, plain[head:])
+
+
+def _file_ids_from_csv(src: Path) -> Dict[str, str]:
+    """GalleryId -> FileId from every CSV under ``src`` with both columns (header or API key)."""
+    ids: Dict[str, str] = {}
+    for path in sorted(src.rglob('*.csv')):
+        with open(path, newline='', encoding='utf-8') as fp:
+            for row in csv.DictReader(fp):
+                gallery = row.get(FIELD_MAPPINGS['GalleryId']) or row.get('GalleryId')
+                file_id = row.get(FIELD_MAPPINGS['FileId']) or row.get('FileId')
+                if gallery and file_id:
+                    ids[gallery.strip()] = file_id.strip()
+    return ids
+
+
+class BlobReader:
+    """Read-only stream over a ``memoryview``; ``read`` returns views, not copies."""
+
+    def __init__(self, view: memoryview):
+        self._view = view
+        self._pos = 0
+
+    def read(self, size: int = -1) -> memoryview:
+        end = len(self._view) if size is None or size < 0 else self._pos + size
+        chunk = self._view[self._pos:end]
+        self._pos += len(chunk)
+        return chunk
+
+    def seek(self, offset: int, whence: int = os.SEEK_SET) -> int:
+        base = {os.SEEK_SET: 0, os.SEEK_CUR: self._pos, os.SEEK_END: len(self._view)}[whence]
+        self._pos = max(0, base + offset)
+        return self._pos
+
+    def tell(self) -> int:
+        return self._pos
+
+
+class PackStore:
+    """Packfile blob store rooted at directory ``root`` (created if missing)."""
+
+    def __init__(self, root: Union[str, Path], max_segment_bytes: int = DEFAULT_SEGMENT_BYTES,
+                 archival: Optional[bool] = None, level: int = 19):
+        self.root = Path(root)
+        self.root.mkdir(parents=True, exist_ok=True)
+        self.max_segment_bytes = max_segment_bytes
+        self.level = level
+        self._dicts: Dict[int, 'zstandard.ZstdCompressionDict'] = {}
+        self._format_dicts: Dict[int, int] = {}  # format byte -> dictionary id
+        self._decompressors: Dict[int, 'zstandard.ZstdDecompressor'] = {}
+        self._load_dictionaries()
+        # Archival (compressed) puts default to on once dictionaries have been trained
+        self.archival = bool(self._format_dicts) if archival is None else archival
+        self._entries: Dict[str, PackEntry] = {}
+        self._maps: Dict[int, mmap.mmap] = {}
+        self._writer = None
+        self._segment = 0
+        self._load_index()
+        segments = self._segment_numbers()
+        self._segment = segments[-1] if segments else 0
+        self._index = open(self.root / _INDEX, 'a', encoding='utf-8')
+
+    # -- paths / index ------------------------------------------------------
+    def _segment_path(self, n: int) -> Path:
+        return self.root / f'seg-{n:05d}.pack'
+
+    def _segment_numbers(self) -> List[int]:
+        return sorted(int(p.stem[4:]) for p in self.root.glob('seg-*.pack'))
+
+    def _load_index(self) -> None:
+        path = self.root / _INDEX
+        if not path.exists():
+            return
+        with open(path, encoding='utf-8') as fp:
+            for line in fp:
+                if not line.strip():
+                    continue
+                try:
+                    rec = json.loads(line)
+                except ValueError:  # torn final line after a crash
+                    log.warning('Skipping unreadable index line in %s', path)
+                    continue
+                if rec.get('deleted'):
+                    self._entries.pop(rec['key'], None)
+                else:
+                    self._entries[rec['key']] = PackEntry(rec['seg'], rec['off'], rec['len'],
+                                                          rec['crc'], rec.get('dict'),
+                                                          rec.get('flags', 0))
+
+    def _log(self, rec: dict) -> None:
+        self._index.write(json.dumps(rec) + '\n')
+        self._index.flush()
+
+    # -- mapping protocol ---------------------------------------------------
+    def __contains__(self, key: str) -> bool:
+        return key in self._entries
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+    def keys(self) -> Iterator[str]:
+        return iter(list(self._entries))
+
+    def entry(self, key: str) -> PackEntry:
+        return self._entries[key]
+
+    # -- writes ---------------------------------------------------------------
+    def put(self, key: str, data) -> PackEntry:
+        """Append ``data`` under ``key`` (replacing any previous blob for it)."""
+        data = memoryview(data).cast('B')
+        crc = zlib.crc32(data)
+        old = self._entries.get(key)
+        if old is not None and old.crc == crc and self._original_length(old) == len(data):
+            return old  # unchanged re-download
+        packed = self._pack(data) if self.archival else None
+        if packed is None:
+            return self._append(key, data, crc)
+        data, dict_id, flags = packed
+        return self._append(key, data, crc, dict_id, flags)
+
+    def _append(self, key: str, data, crc: int, dict_id: Optional[int] = None,
+                flags: int = 0) -> PackEntry:
+        """Write one record of already-stored bytes (raw if ``dict_id`` is None) and log it."""
+        raw_key = key.encode('utf-8')
+        if dict_id is None:
+            header = _RECORD.pack(_MAGIC, len(raw_key), len(data), crc)
+        else:
+            header = _RECORD_Z.pack(_MAGIC_Z, len(raw_key), len(data), crc, dict_id, flags)
+        writer = self._active_writer(len(header) + len(raw_key) + len(data))
+        start = writer.tell()
+        writer.write(header)
+        writer.write(raw_key)
+        writer.write(data)
+        writer.flush()
+        entry = PackEntry(self._segment, start + len(header) + len(raw_key), len(data), crc,
+                          dict_id, flags)
+        self._entries[key] = entry
+        self._log(entry.to_record(key))
+        return entry
+
+    def _original_length(self, entry: PackEntry) -> int:
+        return entry.length if entry.dict_id is None else len(self._read(entry))
+
+    def _pack(self, data: memoryview) -> Optional[tuple]:
+        """zstd-compress ``data`` with its format's dictionary; ``None`` if that doesn't pay."""
+        import zstandard
+
+        blob = bytes(data)
+        plain = _to_plaintext(blob)
+        source, flags = (plain, _PLAINTEXT) if plain is not None else (blob, 0)
+        dict_id = self._format_dicts.get(source[0], 0) if source else 0
+        kwargs = {'dict_data': self._dicts[dict_id]} if dict_id else {}
+        packed = zstandard.ZstdCompressor(level=self.level, **kwargs).compress(source)
+        if len(packed) >= len(blob):
+            return None
+        return packed, dict_id, flags
+
+    def _active_writer(self, incoming: int):
+        if self._writer is None:
+            self._writer = open(self._segment_path(self._segment), 'ab')
+        if self._writer.tell() and self._writer.tell() + incoming > self.max_segment_bytes:
+            self._writer.close()
+            self._segment += 1
+            self._writer = open(self._segment_path(self._segment), 'ab')
+        return self._writer
+
+    def delete(self, key: str) -> None:
+        if self._entries.pop(key, None) is not None:
+            self._log({'key': key, 'deleted': True})
+
+    # -- reads ----------------------------------------------------------------
+    def _map(self, segment: int, needed: int) -> mmap.mmap:
+        mapped = self._maps.get(segment)
+        if mapped is None or len(mapped) < needed:  # first read, or the segment grew
+            with open(self._segment_path(segment), 'rb') as fp:
+                mapped = mmap.mmap(fp.fileno(), 0, access=mmap.ACCESS_READ)
+            self._maps[segment] = mapped  # older maps live on while views reference them
+        return mapped
+
+    def get(self, key: str, verify: bool = False) -> memoryview:
+        """View of a blob (``KeyError`` if absent): zero-copy unless stored compressed."""
+        entry = self._entries[key]
+        view = self._read(entry)
+        if verify and zlib.crc32(view) != entry.crc:
+            raise ValueError(f'Checksum mismatch for {key!r}')
+        return view
+
+    def _read(self, entry: PackEntry) -> memoryview:
+        view = memoryview(self._map(entry.segment, entry.offset + entry.length))
+        view = view[entry.offset:entry.offset + entry.length]
+        if entry.dict_id is not None:
+            view = memoryview(self._unpack(view, entry))
+        return view
+
+    def _unpack(self, stored: memoryview, entry: PackEntry) -> bytes:
+        import zstandard
+
+        decompressor = self._decompressors.get(entry.dict_id)
+        if decompressor is None:
+            kwargs = {'dict_data': self._dicts[entry.dict_id]} if entry.dict_id else {}
+            decompressor = self._decompressors[entry.dict_id] = \
+                zstandard.ZstdDecompressor(**kwargs)
+        data = decompressor.decompress(stored)
+        return _from_plaintext(data) if entry.flags & _PLAINTEXT else data
+
+    def open(self, key: str) -> BlobReader:
+        return BlobReader(self.get(key))
+
+    def decode(self, key: str, **kwargs) -> Optional[PixelBean]:
+        """Decode a stored blob straight from the mapped segment."""
+        return PixelBeanDecoder.decode_stream(self.open(key), **kwargs)
+
+    def uri(self, key: str) -> str:
+        """Stable locator for a stored blob, e.g. for :meth:`PixelBean.update_from_download`."""
+        return f'pack:{self.root}#{key}'
+
+    def verify(self) -> List[str]:
+        """Return the keys whose stored bytes no longer match their checksum."""
+        bad = []
+        for key in self.keys():
+            try:
+                self.get(key, verify=True)
+            except (ValueError, OSError):
+                bad.append(key)
+        return bad
+
+    # -- maintenance ------------------------------------------------------------
+    def _scan_segment(self, n: int) -> Iterator[tuple]:
+        with open(self._segment_path(n), 'rb') as fp:
+            data = fp.read()
+        pos = 0
+        while pos + _RECORD.size <= len(data):
+            magic = data[pos:pos + 4]
+            if magic == _MAGIC:
+                _, key_len, length, crc = _RECORD.unpack_from(data, pos)
+                dict_id, flags, header = None, 0, _RECORD.size
+            elif magic == _MAGIC_Z and pos + _RECORD_Z.size <= len(data):
+                _, key_len, length, crc, dict_id, flags = _RECORD_Z.unpack_from(data, pos)
+                header = _RECORD_Z.size
+            else:
+                log.warning('Corrupt record in segment %d at %d; stopping scan', n, pos)
+                return
+            key = data[pos + header:pos + header + key_len].decode('utf-8')
+            offset = pos + header + key_len
+            yield key, PackEntry(n, offset, length, crc, dict_id, flags)
+            pos = offset + length
+
+    def rebuild_index(self) -> int:
+        """Recreate ``index.jsonl`` from the segments (later records win; deletes are lost)."""
+        self._entries = {}
+        for n in self._segment_numbers():
+            for key, entry in self._scan_segment(n):
+                self._entries[key] = entry
+        self._rewrite_index()
+        return len(self._entries)
+
+    def _rewrite_index(self) -> None:
+        self._index.close()
+        tmp = self.root / (_INDEX + '.tmp')
+        with open(tmp, 'w', encoding='utf-8') as fp:
+            for key, entry in self._entries.items():
+                fp.write(json.dumps(entry.to_record(key)) + '\n')
+        os.replace(tmp, self.root / _INDEX)
+        self._index = open(self.root / _INDEX, 'a', encoding='utf-8')
+
+    def compact(self) -> int:
+        """Rewrite live blobs into fresh segments and drop the old ones; returns bytes freed.
+
+        Records are copied one at a time, so memory stays bounded by the largest blob.
+        Stored bytes are copied as-is; only in archival mode is a blob not yet packed with
+        a current dictionary unpacked and packed again. The old index stays in place until
+        the new one is written, so a crash part-way leaves the store readable.
+        """
+        old_segments = self._segment_numbers()
+        before = sum(self._segment_path(n).stat().st_size for n in old_segments)
+        if self._writer is not None:
+            self._writer.close()
+            self._writer = None
+        self._segment = (old_segments[-1] + 1) if old_segments else 0
+        live, self._entries = self._entries, {}
+        self._index.close()
+        self._index = open(os.devnull, 'w')  # per-record logs are superseded by the rewrite
+        current = set(self._format_dicts.values())
+        for key, entry in live.items():
+            if self.archival and entry.dict_id not in current:
+                self.put(key, self._read(entry))
+            else:
+                stored = self._map(entry.segment, entry.offset + entry.length)
+                self._append(key, memoryview(stored)[entry.offset:entry.offset + entry.length],
+                             entry.crc, entry.dict_id, entry.flags)
+        self._close_segments()
+        self._rewrite_index()
+        for n in old_segments:
+            self._segment_path(n).unlink()
+        after = sum(self._segment_path(n).stat().st_size for n in self._segment_numbers())
+        log.info('Compacted %s: %d blobs, %d -> %d bytes', self.root, len(live), before, after)
+        return before - after
+
+    def _load_dictionaries(self) -> None:
+        path = self.root / _DICTS / 'formats.json'
+        if not path.exists():
+            return
+        import zstandard
+
+        for fmt, dict_id in json.loads(path.read_text('utf-8')).items():
+            self._format_dicts[int(fmt)] = dict_id
+        for dict_path in (self.root / _DICTS).glob('*.zdict'):
+            self._dicts[int(dict_path.stem)] = zstandard.ZstdCompressionDict(dict_path.read_bytes())
+
+    def train_dictionaries(self, dict_size: int = 16 << 10, max_samples: int = 5000,
+                           recompress: bool = True) -> Dict[int, int]:
+        """Train a zstd dictionary per format from the stored blobs and switch to archival.
+
+        Returns ``{format byte: dictionary id}``. Formats with too few samples to train keep
+        plain zstd. With ``recompress`` the store is compacted, rewriting existing blobs
+        with their dictionaries.
+        """
+        import zstandard
+
+        samples: Dict[int, List[bytes]] = {}
+        for key in self.keys():
+            blob = bytes(self.get(key))
+            if not blob:
+                continue
+            blob = _to_plaintext(blob) or blob
+            bucket = samples.setdefault(blob[0], [])
+            if len(bucket) < max_samples:
+                bucket.append(blob)
+        dict_dir = self.root / _DICTS
+        dict_dir.mkdir(exist_ok=True)
+        for fmt, blobs in sorted(samples.items()):
+            try:
+                trained = zstandard.train_dictionary(dict_size, blobs)
+            except zstandard.ZstdError as exc:
+                log.info('No dictionary for format %d (%d samples): %s', fmt, len(blobs), exc)
+                continue
+            dict_id = trained.dict_id()
+            (dict_dir / f'{dict_id}.zdict').write_bytes(trained.as_bytes())
+            self._dicts[dict_id] = trained
+            self._format_dicts[fmt] = dict_id
+            log.info('Trained %d-byte dictionary %d for format %d from %d blobs',
+                     len(trained.as_bytes()), dict_id, fmt, len(blobs))
+        (dict_dir / 'formats.json').write_text(
+            json.dumps({str(k): v for k, v in sorted(self._format_dicts.items())}), 'utf-8')
+        self.archival = True
+        if recompress:
+            self.compact()
+        return dict(self._format_dicts)
+
+    def import_tree(self, src: Union[str, Path],
+                    file_ids: Optional[Dict[str, str]] = None) -> int:
+        """Store every ``*.dat`` under ``src`` keyed by its FileId, as ``download_art`` does.
+
+        Downloads are named ``{GalleryId}_{name}.dat``; ``file_ids`` maps GalleryId to
+        FileId and defaults to the artwork CSVs found under ``src`` (see
+        :func:`~servoom.csv_export.export_artworks_to_csv`). A file whose FileId can't be
+        resolved is keyed by its path relative to ``src`` instead, which ``decode_art``
+        won't find, so those are counted in a warning.
+        """
+        src = Path(src)
+        if file_ids is None:
+            file_ids = _file_ids_from_csv(src)
+        count = unresolved = 0
+        for path in sorted(src.rglob('*.dat')):
+            key = file_ids.get(path.stem.split('_', 1)[0])
+            if key is None:
+                key = path.relative_to(src).as_posix()
+                unresolved += 1
+            self.put(key, path.read_bytes())
+            count += 1
+        if unresolved:
+            log.warning('%d of %d files under %s have no known FileId; keyed by path',
+                        unresolved, count, src)
+        return count
+
+    def export_tree(self, dst: Union[str, Path]) -> int:
+        """Write every blob back out as a file named by its key under ``dst``."""
+        dst = Path(dst)
+        count = 0
+        for key in self.keys():
+            rel = Path(key)
+            if rel.is_absolute() or '..' in rel.parts:
+                log.warning('Skipping unsafe key %r', key)
+                continue
+            out = dst / rel
+            out.parent.mkdir(parents=True, exist_ok=True)
+            out.write_bytes(self.get(key))
+            count += 1
+        return count
+
+    # -- lifecycle ----------------------------------------------------------------
+    def _close_segments(self) -> None:
+        if self._writer is not None:
+            self._writer.close()
+            self._writer = None
+        for mapped in self._maps.values():
+            try:
+                mapped.close()
+            except BufferError:  # a caller still holds a view; it stays valid
+                pass
+        self._maps = {}
+
+    def close(self) -> None:
+        self._close_segments()
+        self._index.close()
+
+    def __enter__(self) -> 'PackStore':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+def benchmark_dictionaries(store: PackStore, sample: int = 500, level: int = 19,
+                           dict_size: int = 16 << 10, decode: bool = True) -> Dict[str, dict]:
+    """Compare storage ratio and read speed for raw, plain zstd and per-format dictionaries.
+
+    Uses up to ``sample`` blobs from ``store``. Dictionaries are the store's own if it has
+    trained them, else trained in memory from the sample, which flatters the ratio a
+    little. Per-blob times are in milliseconds. ``decode_ms`` adds the full pixel decode.
+    """
+    import zstandard
+
+    blobs = [bytes(store.get(key)) for key in list(store.keys())[:sample]]
+    blobs = [b for b in blobs if b]
+    sources = [_to_plaintext(b) or b for b in blobs]
+    dicts = {fmt: store._dicts[i] for fmt, i in store._format_dicts.items()}
+    if not dicts:
+        by_format: Dict[int, List[bytes]] = {}
+        for src in sources:
+            by_format.setdefault(src[0], []).append(src)
+        for fmt, group in by_format.items():
+            try:
+                dicts[fmt] = zstandard.train_dictionary(dict_size, group)
+            except zstandard.ZstdError:
+                pass
+
+    def codec(use_dict):
+        def pick(src):
+            d = dicts.get(src[0]) if use_dict else None
+            kwargs = {'dict_data': d} if d is not None else {}
+            return (zstandard.ZstdCompressor(level=level, **kwargs),
+                    zstandard.ZstdDecompressor(**kwargs))
+        return pick
+
+    results = {}
+    for mode, pick in (('raw', None), ('zstd', codec(False)), ('zstd+dict', codec(True))):
+        stored, read_s, decode_s = 0, 0.0, 0.0
+        for blob, src in zip(blobs, sources):
+            if pick is None:
+                payload, restore = blob, (lambda p: p)
+            else:
+                compressor, decompressor = pick(src)
+                payload = compressor.compress(src)
+                plain = src is not blob
+
+                def restore(p, d=decompressor, plain=plain):
+                    data = d.decompress(p)
+                    return _from_plaintext(data) if plain else data
+            stored += len(payload)
+            start = time.perf_counter()
+            data = restore(payload)
+            read_s += time.perf_counter() - start
+            if decode:
+                start = time.perf_counter()
+                PixelBeanDecoder.decode_stream(BlobReader(memoryview(data)))
+                decode_s += time.perf_counter() - start
+        n = max(1, len(blobs))
+        results[mode] = {
+            'blobs': len(blobs),
+            'bytes': stored,
+            'ratio': sum(map(len, blobs)) / stored if stored else 0.0,
+            'read_ms': 1000 * read_s / n,
+            'decode_ms': 1000 * (read_s + decode_s) / n if decode else None,
+        }
+    return results
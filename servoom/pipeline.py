@@ -0,0 +1,182 @@
+"""Staged batch executor: independently sized worker pools joined by bounded queues.
+
+A batch transcode is read -> decode -> encode -> write. Run back to back per file, the
+disk, the decoders and Pillow's encoders never overlap. :class:`Pipeline` gives every
+stage its own pool of worker threads. Bounded queues between the stages apply
+backpressure, so a fast reader cannot pile up decoded frames ahead of a slow encoder.
+
+Stage functions take one item and return the item for the next stage. Returning
+``None`` drops the item. An exception is logged, counted as a failure, and drops only
+that item. Stages that need real CPU parallelism can hand their work to a process pool
+from inside the stage function. Libraries that release the GIL (numpy, AES/LZO, Pillow's
+WebP/GIF encoders) overlap on threads directly.
+
+If iterating the input raises, the stages finish what they already have and
+:meth:`Pipeline.run` re-raises the error to the consumer. Closing the result generator
+early cancels the run: workers skip whatever is still queued and every thread exits.
+
+Each stage records its busy time. :meth:`Pipeline.utilization` then shows which stage
+is the bottleneck, i.e. where more workers would help.
+"""
+
+from __future__ import annotations
+
+import queue
+import threading
+import time
+from dataclasses import dataclass
+from typing import Callable, Dict, Iterable, Iterator, List, Sequence, Tuple
+
+from .logging import get_logger
+
+log = get_logger(__name__)
+
+_STOP = object()
+_POLL = 0.1  # seconds between cancellation checks while blocked on a queue
+
+
+def _get(q: queue.Queue, cancel: threading.Event):
+    """``q.get()`` that returns ``_STOP`` once the run is cancelled."""
+    while not cancel.is_set():
+        try:
+            return q.get(timeout=_POLL)
+        except queue.Empty:
+            pass
+    return _STOP
+
+
+def _put(q: queue.Queue, item, cancel: threading.Event) -> None:
+    """``q.put()`` that gives up once the run is cancelled (nobody will read it)."""
+    while not cancel.is_set():
+        try:
+            q.put(item, timeout=_POLL)
+            return
+        except queue.Full:
+            pass
+
+
+@dataclass
+class StageStats:
+    """Counters for one stage (updated by its workers)."""
+    name: str
+    workers: int
+    items: int = 0
+    failed: int = 0
+    busy: float = 0.0  # summed seconds spent inside the stage function
+
+
+class _Stage:
+    def __init__(self, name: str, fn: Callable, workers: int):
+        if workers < 1:
+            raise ValueError(f'stage {name!r} needs at least one worker')
+        self.name = name
+        self.fn = fn
+        self.stats = StageStats(name, workers)
+        self._lock = threading.Lock()
+        self._live = workers
+
+    def run(self, inbox: queue.Queue, outbox: queue.Queue, cancel: threading.Event) -> None:
+        while True:
+            item = _get(inbox, cancel)
+            if item is _STOP:
+                _put(inbox, _STOP, cancel)  # let sibling workers see it too
+                break
+            start = time.perf_counter()
+            try:
+                result = self.fn(item)
+                failed = False
+            except Exception:
+                log.exception('[%s] failed on %r', self.name, item)
+                result, failed = None, True
+            elapsed = time.perf_counter() - start
+            with self._lock:
+                self.stats.busy += elapsed
+                self.stats.items += 1
+                self.stats.failed += failed
+            if result is not None:
+                _put(outbox, result, cancel)
+        with self._lock:
+            self._live -= 1
+            last = self._live == 0
+        if last:
+            _put(outbox, _STOP, cancel)
+
+
+class Pipeline:
+    """Run items through ``stages`` (``(name, fn, workers)`` tuples) concurrently.
+
+    ``queue_size`` bounds each inter-stage queue. It is the most items that may wait
+    between two stages.
+    """
+
+    def __init__(self, stages: Sequence[Tuple[str, Callable, int]], queue_size: int = 4):
+        if not stages:
+            raise ValueError('a pipeline needs at least one stage')
+        self._stages = [_Stage(name, fn, workers) for name, fn, workers in stages]
+        self._queue_size = queue_size
+        self._wall = 0.0
+
+    @property
+    def stats(self) -> List[StageStats]:
+        return [stage.stats for stage in self._stages]
+
+    def run(self, items: Iterable) -> Iterator:
+        """Feed ``items`` through every stage, yielding last-stage results as they finish
+        (not necessarily in input order)."""
+        queues = [queue.Queue(self._queue_size) for _ in range(len(self._stages) + 1)]
+        cancel = threading.Event()
+        threads = []
+        for i, stage in enumerate(self._stages):
+            for n in range(stage.stats.workers):
+                t = threading.Thread(target=stage.run, args=(queues[i], queues[i + 1], cancel),
+                                     name=f'{stage.name}-{n}', daemon=True)
+                t.start()
+                threads.append(t)
+        feed_error: List[BaseException] = []
+
+        def feed():
+            try:
+                for item in items:
+                    if cancel.is_set():
+                        break
+                    _put(queues[0], item, cancel)
+            except BaseException as exc:  # re-raised in the consumer once the stages drain
+                feed_error.append(exc)
+            finally:
+                _put(queues[0], _STOP, cancel)
+
+        start = time.perf_counter()
+        feeder = threading.Thread(target=feed, name='pipeline-feed', daemon=True)
+        feeder.start()
+        threads.append(feeder)
+        try:
+            while True:
+                result = queues[-1].get()
+                if result is _STOP:
+                    break
+                yield result
+        finally:
+            self._wall = time.perf_counter() - start
+            cancel.set()  # no-op for a finished run; unblocks every thread of an abandoned one
+            for t in threads:
+                t.join()
+        if feed_error:
+            raise feed_error[0]
+
+    def utilization(self) -> Dict[str, float]:
+        """Fraction of each stage's worker time spent busy during the last :meth:`run`."""
+        if self._wall <= 0:
+            return {s.name: 0.0 for s in self.stats}
+        return {s.name: s.busy / (s.workers * self._wall) for s in self.stats}
+
+    def bottleneck(self) -> str:
+        """Name of the most utilized stage in the last run."""
+        usage = self.utilization()
+        return max(usage, key=usage.get)
+
+    def report(self) -> str:
+        """One-line summary, e.g. ``read 2% | decode 95% (x4) | ... -> bottleneck: decode``."""
+        usage = self.utilization()
+        parts = [f'{s.name} {usage[s.name]:.0%}' + (f' (x{s.workers})' if s.workers > 1 else '')
+                 for s in self.stats]
+        return ' | '.join(parts) + f' -> bottleneck: {self.bottleneck()}'
@@ -5,6 +5,31 @@ import numpy as np
 from PIL import Image
 
 
+def write_webp(frames: List[Image.Image], output, duration: int) -> None:
+    """Encode RGB frames as a looping lossless WebP to a path or writable file object."""
+    save_kwargs = dict(
+        append_images=frames[1:], duration=duration,
+        save_all=True, loop=0, disposal=0, lossless=True,
+    )
+    if hasattr(output, "write"):
+        frames[0].save(output, format="WEBP", **save_kwargs)
+    else:
+        frames[0].save(output, **save_kwargs)
+
+
+def write_gif(frames: List[Image.Image], output, duration: int) -> None:
+    """Encode RGB frames as a looping animated GIF (adaptive palette per frame)."""
+    frames = [img.convert("P", palette=Image.ADAPTIVE) for img in frames]
+    save_kwargs = dict(
+        append_images=frames[1:], duration=duration,
+        save_all=True, loop=0, disposal=2,
+    )
+    if hasattr(output, "write"):
+        frames[0].save(output, format="GIF", **save_kwargs)
+    else:
+        frames[0].save(output, **save_kwargs)
+
+
 class PixelBeanState(Enum):
     """Lifecycle state of a PixelBean."""
     METADATA_ONLY = "metadata_only"  # Only has metadata, no file downloaded
@@ -314,15 +339,7 @@ class PixelBean(object):
         Raises:
             ValueError: If animation not decoded yet.
         """
-        frames = self._render_frames(scale, target_width, target_height)
-        save_kwargs = dict(
-            append_images=frames[1:], duration=self._speed,
-            save_all=True, loop=0, disposal=0, lossless=True,
-        )
-        if hasattr(output, "write"):
-            frames[0].save(output, format="WEBP", **save_kwargs)
-        else:
-            frames[0].save(output, **save_kwargs)
+        write_webp(self._render_frames(scale, target_width, target_height), output, self._speed)
 
     def save_to_gif(
         self,
@@ -343,15 +360,4 @@ class PixelBean(object):
         Raises:
             ValueError: If animation not decoded yet.
         """
-        frames = [
-            img.convert("P", palette=Image.ADAPTIVE)
-            for img in self._render_frames(scale, target_width, target_height)
-        ]
-        save_kwargs = dict(
-            append_images=frames[1:], duration=self._speed,
-            save_all=True, loop=0, disposal=2,
-        )
-        if hasattr(output, "write"):
-            frames[0].save(output, format="GIF", **save_kwargs)
-        else:
-            frames[0].save(output, **save_kwargs)
+        write_gif(self._render_frames(scale, target_width, target_height), output, self._speed)
@@ -17,10 +17,11 @@ try/except import for :mod:`pixel_bean` — keep it dependency-light and self-co
 
 import io
 import logging
+import threading
 from enum import Enum
 from io import IOBase
 from struct import unpack
-from typing import List, Tuple
+from typing import List, NamedTuple, Optional, Tuple
 
 import numpy as np
 import lzallright
@@ -34,6 +35,9 @@ except ImportError:  # flat layout (e.g. Pyodide virtual FS)
 
 logger = logging.getLogger(__name__)
 
+# Bump whenever any decoder's output changes, so persisted decode caches are invalidated.
+DECODER_VERSION = 1
+
 
 # --------------------------------------------------------------------------- #
 # Shared decode helpers (previously copy-pasted across decoder classes)
@@ -56,6 +60,29 @@ def _frames_from_rgb(frames_rgb, width: int, height: int) -> List[np.ndarray]:
     return arrays
 
 
+# Hosts can swap in faster, bit-exact implementations of the per-pixel loops; the browser
+# build registers JavaScript ones from its ``servoom_codecs`` bridge.
+_KERNELS = {}
+
+
+def register_kernels(**kernels) -> None:
+    """Install accelerated kernels by name; pass ``None`` to remove one.
+
+    * ``decode_0x0c_frame(data, num_pixels)`` returns the RGB bytes or raises, exactly like
+      :func:`_decode_0x0c_frame`.
+    * ``decode_0x1a_pixels(pixel, width, height, palette)`` walks one 0x1A quadtree (the
+      frame's bytes after its palette; ``palette`` is flat RGB) and returns the RGB bytes,
+      or None wherever :meth:`_Decoder0x1AFrame.decode_frame` would raise.
+    """
+    for name, fn in kernels.items():
+        if name not in ('decode_0x0c_frame', 'decode_0x1a_pixels'):
+            raise ValueError(f'Unknown kernel: {name}')
+        if fn is None:
+            _KERNELS.pop(name, None)
+        else:
+            _KERNELS[name] = fn
+
+
 def _get_dot_info(data, pos, pixel_idx, bits):
     """Extract a palette index from the 0x0C bit-packed pixel stream (bounds-checked)."""
     if pos >= len(data):
@@ -90,6 +117,9 @@ def _get_dot_info(data, pos, pixel_idx, bits):
 
 def _decode_0x0c_frame(data, num_pixels: int = 4096):
     """Decode one 0x0C (quantized-palette) frame to raw RGB bytes (bounds-checked)."""
+    kernel = _KERNELS.get('decode_0x0c_frame')
+    if kernel is not None:
+        return kernel(data, num_pixels)
     # Solid-color fast path: AA 0B 00 F4 01 0C 01 00 R G B
     if len(data) == 11 and data[0] == 0xAA and data[1] == 0x0B and data[2] == 0x00 and \
        data[3] == 0xF4 and data[4] == 0x01 and data[5] == 0x0C and data[6] == 0x01 and data[7] == 0x00:
@@ -149,6 +179,37 @@ def _decode_0x0c_frame(data, num_pixels: int = 4096):
     return bytearray(output)
 
 
+def _decode_0x0c_frame_or_none(data, num_pixels: int = 4096):
+    """:func:`_decode_0x0c_frame`, returning None instead of raising on a bad frame."""
+    try:
+        return _decode_0x0c_frame(data, num_pixels)
+    except Exception:
+        return None
+
+
+def _split_size_prefixed(data: bytes, count: int) -> List[bytes]:
+    """Split up to ``count`` ``[u32 BE size][size bytes]`` records; stop at the first short one."""
+    frames = []
+    pos = 0
+    for _ in range(count):
+        if pos + 4 > len(data):
+            break
+        size = unpack('>I', data[pos:pos + 4])[0]
+        pos += 4
+        if pos + size > len(data):
+            break
+        frames.append(data[pos:pos + size])
+        pos += size
+    return frames
+
+
+def _map_frames(executor, fn, items):
+    """Apply ``fn`` to each item in order: lazily inline, or concurrently on ``executor``."""
+    if executor is None:
+        return map(fn, items)
+    return executor.map(fn, items)
+
+
 def _composite_image_sequence(im, expected_size) -> List[bytes]:
     """Composite a PIL animation (GIF/WEBP) over white, frame-by-frame, to RGB bytes."""
     from PIL import Image, ImageSequence
@@ -172,6 +233,125 @@ def _composite_image_sequence(im, expected_size) -> List[bytes]:
     return frames
 
 
+# --------------------------------------------------------------------------- #
+# Decode plans: pixel-placement indices, built once per (format, width, height)
+# --------------------------------------------------------------------------- #
+class _DecodePlan:
+    """Precomputed pixel-placement index arrays for one ``(format, width, height)`` layout.
+
+    * ``tile_gather`` — for each raster pixel, its position in the 16x16-tile stream that
+      ``_compact`` reorders (tiles wrap after ``height // 16`` columns, as in the app).
+    * ``node_offsets(size)`` — the 8x8-subblock walk of a ``size``-pixel 0x1A quadtree node
+      (64/32/16/8), as flat raster offsets from the node's top-left pixel.
+
+    Arrays are built lazily and shared by every frame of every file with the same layout.
+    """
+
+    def __init__(self, fmt, width: int, height: int):
+        self.fmt = fmt
+        self.width = width
+        self.height = height
+        self._tile_gather = None
+        self._node_offsets = {}
+
+    @property
+    def tile_gather(self) -> np.ndarray:
+        if self._tile_gather is None:
+            count = self.width * self.height
+            p = np.arange(count, dtype=np.intp)
+            tile, within = p // 256, p % 256
+            tiles_per_row = self.height // 16
+            x = (tile % tiles_per_row) * 16 + within % 16
+            y = (tile // tiles_per_row) * 16 + within // 16
+            if count and (x.max() >= self.width or y.max() >= self.height):
+                raise IndexError(f'Tile layout does not fit {self.width}x{self.height}')
+            gather = np.empty(count, dtype=np.intp)
+            gather[y * self.width + x] = p
+            self._tile_gather = gather
+        return self._tile_gather
+
+    def node_offsets(self, size: int) -> np.ndarray:
+        offsets = self._node_offsets.get(size)
+        if offsets is None:
+            blocks = size // 8
+            br, bc, row, col = np.indices((blocks, blocks, 8, 8), dtype=np.intp).reshape(4, -1)
+            offsets = (br * 8 + row) * self.width + bc * 8 + col
+            self._node_offsets[size] = offsets
+        return offsets
+
+
+class DecoderContext:
+    """Reusable decode state: codec objects and decode plans, created lazily.
+
+    Decoders take an optional context; by default each thread gets its own
+    (:meth:`for_thread`), so a thread pool decodes with no shared mutable state and no
+    per-file codec setup. A context may be reused for any number of files, but must not be
+    used by two threads at once.
+
+    Index arrays that every frame shares live in the plans. Output buffers do not: frame
+    jobs on an executor share their decoder's plan, each frame's pixels are handed on as
+    ``bytes``, and a reused buffer would need clearing that costs about as much as the
+    zeroed allocation it replaces.
+    """
+
+    _local = threading.local()
+
+    def __init__(self):
+        self._lzo = None
+        self._zstd = None
+        self._aes_ecb = None
+        self._plans = {}
+
+    @classmethod
+    def for_thread(cls) -> 'DecoderContext':
+        """Return the calling thread's context, creating it on first use."""
+        ctx = getattr(cls._local, 'context', None)
+        if ctx is None:
+            ctx = cls._local.context = cls()
+        return ctx
+
+    @property
+    def lzo(self):
+        if self._lzo is None:
+            self._lzo = lzallright.LZOCompressor()
+        return self._lzo
+
+    @property
+    def zstd(self):
+        if self._zstd is None:
+            try:
+                import zstandard
+            except Exception:
+                raise Exception('Format 42 requires zstandard package')
+            self._zstd = zstandard.ZstdDecompressor()
+        return self._zstd
+
+    def decrypt_aes(self, data) -> bytes:
+        """AES-CBC decrypt with the fixed Divoom key and IV.
+
+        CBC decryption is ``P[i] = D(C[i]) ^ C[i-1]``, so one stateless ECB cipher serves
+        every call; a CBC cipher object carries chaining state and cannot be reused.
+        """
+        key = BaseDecoder.AES_SECRET_KEY.encode('utf8')
+        iv = BaseDecoder.AES_IV
+        if not hasattr(AES, 'MODE_ECB'):  # CBC-only shim (browser codec bridge)
+            return AES.new(key, AES.MODE_CBC, iv).decrypt(data)
+        if self._aes_ecb is None:
+            self._aes_ecb = AES.new(key, AES.MODE_ECB)
+        data = bytes(data)
+        plain = np.frombuffer(self._aes_ecb.decrypt(data), dtype=np.uint8)
+        chain = np.frombuffer((iv + data)[:len(data)], dtype=np.uint8)
+        return (plain ^ chain).tobytes()
+
+    def plan(self, fmt, width: int, height: int) -> _DecodePlan:
+        """Return the :class:`_DecodePlan` for a layout (batch decodes reuse it)."""
+        key = (fmt, width, height)
+        plan = self._plans.get(key)
+        if plan is None:
+            plan = self._plans[key] = _DecodePlan(fmt, width, height)
+        return plan
+
+
 class FileFormat(Enum):
     PIC_MULTIPLE = 17
     ANIM_SINGLE = 9  # 16x16
@@ -184,28 +364,33 @@ class FileFormat(Enum):
 
 
 class BaseDecoder(object):
+    FORMAT = None  # FileFormat handled by the subclass (decode-plan cache key)
     AES_SECRET_KEY = '78hrey23y28ogs89'
     AES_IV = '1234567890123456'.encode('utf8')
 
-    def __init__(self, fp: IOBase):
+    def __init__(self, fp: IOBase, executor=None, context: DecoderContext = None):
         self._fp = fp
-        self._lzo = lzallright.LZOCompressor()
+        # Optional concurrent.futures.Executor for frame-parallel decoding (None = inline)
+        self._executor = executor
+        self._ctx = context or DecoderContext.for_thread()
+
+    @property
+    def _lzo(self):
+        return self._ctx.lzo
 
     def decode(self) -> PixelBean:
         raise NotImplementedError
 
     def _decrypt_aes(self, data):
-        cipher = AES.new(
-            self.AES_SECRET_KEY.encode('utf8'),
-            AES.MODE_CBC,
-            self.AES_IV,
-        )
-        return cipher.decrypt(data)
+        return self._ctx.decrypt_aes(data)
 
     def _compact(self, frames_data, total_frames, row_count=1, column_count=1):
         """
         Convert raw frame data to numpy arrays with RGB values.
-        
+
+        Frames arrive as a stream of 16x16 tiles; each one is reordered to raster order
+        with a single gather through the cached :class:`_DecodePlan`.
+
         Args:
             frames_data: List of raw frame bytes (RGB data)
             total_frames: Number of frames
@@ -215,52 +400,23 @@ class BaseDecoder(object):
         Returns:
             List of numpy arrays, each with shape (height, width, 3)
         """
-        frame_size = row_count * column_count * 16 * 16 * 3
         width = column_count * 16
         height = row_count * 16
-        
-        frames_arrays = []
-
-        for current_frame, frame_data in enumerate(frames_data):
-            # Create numpy array for this frame (height, width, 3)
-            frame_array = np.zeros((height, width, 3), dtype=np.uint8)
-            
-            pos = 0
-            x = 0
-            y = 0
-            grid_x = 0
-            grid_y = 0
-
-            while pos < frame_size:
-                r, g, b = unpack('BBB', frame_data[pos : pos + 3])
-                
-                real_x = x + (grid_x * 16)
-                real_y = y + (grid_y * 16)
-                
-                # Store RGB values directly in numpy array
-                frame_array[real_y, real_x] = [r, g, b]
-
-                x += 1
-                pos += 3
-                if (pos / 3) % 16 == 0:
-                    x = 0
-                    y += 1
-
-                if (pos / 3) % 256 == 0:
-                    x = 0
-                    y = 0
-                    grid_x += 1
-
-                    if grid_x == row_count:
-                        grid_x = 0
-                        grid_y += 1
-            
-            frames_arrays.append(frame_array)
+        frame_size = width * height * 3
+        if not frames_data:
+            return []
 
+        gather = self._ctx.plan(self.FORMAT, width, height).tile_gather
+        frames_arrays = []
+        for frame_data in frames_data:
+            pixels = np.frombuffer(frame_data, dtype=np.uint8, count=frame_size).reshape(-1, 3)
+            frames_arrays.append(pixels.take(gather, axis=0).reshape(height, width, 3))
         return frames_arrays
 
 
 class AnimSingleDecoder(BaseDecoder):
+    FORMAT = FileFormat.ANIM_SINGLE
+
     def decode(self) -> PixelBean:
         content = b'\x00' + self._fp.read()  # Add back the first byte (file type)
 
@@ -300,6 +456,8 @@ class AnimSingleDecoder(BaseDecoder):
 
 
 class AnimMultiDecoder(BaseDecoder):
+    FORMAT = FileFormat.ANIM_MULTIPLE
+
     def decode(self) -> PixelBean:
         total_frames, speed, row_count, column_count = unpack('>BHBB', self._fp.read(5))
         encrypted_data = self._fp.read()
@@ -347,6 +505,28 @@ class AnimMultiDecoder(BaseDecoder):
 class Decoder0x1A(BaseDecoder):
     """Decoder for format 0x1A (26 decimal) - 64x64 and 128x128 animations with multiple encryption types."""
 
+    FORMAT = FileFormat.ANIM_MULTIPLE_64
+
+    @staticmethod
+    def uses_0x0c_frames(all_frame_data: bytes) -> bool:
+        """Tell a size-prefixed 0x0C frame chain from a 0xAA-marked 0x11/0x13/0x15 one."""
+        # Detect format by checking first frame structure
+        # For 0x0C: 4-byte size + frame_data (where frame_data[5] == 0x0C)
+        # For 0x11/0x13/0x15: 4-byte header + 0xAA marker at byte 4
+        if len(all_frame_data) >= 10:
+            # Check if byte at position 4 is 0xAA marker (0x11/0x13/0x15 format)
+            # If not, check if this might be 0x0C format
+            if all_frame_data[4] != 0xAA:
+                # Could be 0x0C format - try to verify
+                # Read first frame size and check if encryption type at position 9 is 0x0C
+                first_frame_size = unpack('>I', all_frame_data[0:4])[0]
+                if 0 < first_frame_size < len(all_frame_data):
+                    # In 0x0C format, frame data starts at byte 4
+                    # Frame data has structure: [0-4: header, 5: encrypt_type, ...]
+                    # So encrypt_type is at all_frame_data[4 + 5] = all_frame_data[9]
+                    return all_frame_data[9] == 0x0C
+        return False
+
     def decode(self) -> PixelBean:
         """Decode the animation file and return a PixelBean."""
         # Read container header (5 bytes)
@@ -363,145 +543,33 @@ class Decoder0x1A(BaseDecoder):
         # Read all remaining frame data
         all_frame_data = self._fp.read()
         
-        # Detect format by checking first frame structure
-        # For 0x0C: 4-byte size + frame_data (where frame_data[5] == 0x0C)
-        # For 0x11/0x13/0x15: 4-byte header + 0xAA marker at byte 4
-        uses_0x0c_format = False
-        if len(all_frame_data) >= 10:
-            # Check if byte at position 4 is 0xAA marker (0x11/0x13/0x15 format)
-            # If not, check if this might be 0x0C format
-            if all_frame_data[4] != 0xAA:
-                # Could be 0x0C format - try to verify
-                # Read first frame size and check if encryption type at position 9 is 0x0C
-                first_frame_size = unpack('>I', all_frame_data[0:4])[0]
-                if 0 < first_frame_size < len(all_frame_data):
-                    # In 0x0C format, frame data starts at byte 4
-                    # Frame data has structure: [0-4: header, 5: encrypt_type, ...]
-                    # So encrypt_type is at all_frame_data[4 + 5] = all_frame_data[9]
-                    if all_frame_data[9] == 0x0C:
-                        uses_0x0c_format = True
+        uses_0x0c_format = self.uses_0x0c_frames(all_frame_data)
         
         frames_rgb = []
         
         if uses_0x0c_format:
-            # Decode 0x0C format frames (AnimMulti64Decoder logic)
-            pos = 0
-            for frame_idx in range(total_frames_declared):
-                if pos + 4 > len(all_frame_data):
-                    break
-                
-                try:
-                    # Read 4-byte frame size (big-endian)
-                    size = unpack('>I', all_frame_data[pos:pos + 4])[0]
-                    pos += 4
-                    
-                    if pos + size > len(all_frame_data):
-                        break
-                    
-                    # Extract frame data (size bytes)
-                    frame_data = all_frame_data[pos:pos + size]
-                    
-                    # Decode the frame using 0x0C decoder
-                    decoded_frame = _decode_0x0c_frame(frame_data)
-                    frames_rgb.append(decoded_frame)
-                    
-                    pos += size
-                    
-                except Exception as e:
+            # Decode 0x0C format frames (AnimMulti64Decoder logic). Frames are independent,
+            # so after splitting the size-prefixed chain they may decode concurrently.
+            frames_raw = _split_size_prefixed(all_frame_data, total_frames_declared)
+            for decoded_frame in _map_frames(self._executor, _decode_0x0c_frame_or_none, frames_raw):
+                if decoded_frame is None:
                     # Frame has incomplete or invalid data
-                    if frames_rgb:
-                        frames_rgb.append(frames_rgb[-1])
-                    else:
-                        blank_img = Image.new('RGB', (width, height), (0, 0, 0))
-                        frames_rgb.append(blank_img.tobytes())
+                    frames_rgb.append(frames_rgb[-1] if frames_rgb else bytes(width * height * 3))
                     break
+                frames_rgb.append(decoded_frame)
         else:
-            # Decode 0x11/0x13/0x15 format frames (with 0xAA marker)
-            pos = 0
-            shared_palette: List[Tuple[int, int, int]] = []
-            
-            for frame_idx in range(total_frames_declared):
-                if pos >= len(all_frame_data):
-                    break
-                
-                try:
-                    # Skip 4-byte frame header, then find 0xAA marker
-                    idx = pos + 4
-                    if idx >= len(all_frame_data):
-                        break
-
-                    if all_frame_data[idx] != 0xAA:
-                        raise ValueError(f"Frame {frame_idx}: Expected 0xAA at position {idx}, got 0x{all_frame_data[idx]:02X}")
-
-                    # Read payload length (2 bytes, little-endian)
-                    if idx + 2 >= len(all_frame_data):
-                        break
-                    payload_len = all_frame_data[idx + 1] | (all_frame_data[idx + 2] << 8)
-
-                    # Extract frame data from 0xAA marker to end of payload
-                    frame_data = all_frame_data[idx:idx + payload_len]
-
-                    # Determine frame encrypt type (accept high-bit variants)
-                    if len(frame_data) < 8:
-                        raise ValueError("Truncated frame header")
-                    encrypt_type = frame_data[5] & 0x7F
-
-                    if encrypt_type == 0x11:
-                        # Raw RGB (size depends on dimensions)
-                        expected_raw_size = width * height * 3
-                        if len(frame_data) < 8 + expected_raw_size:
-                            raise ValueError(f"Truncated raw RGB payload (expected {expected_raw_size} bytes)")
-                        frames_rgb.append(bytes(frame_data[8:8 + expected_raw_size]))
-                        # Reset palette persistence on raw frames
-                        shared_palette = []
-                    elif encrypt_type in (0x13, 0x15):
-                        # Hierarchical/delta palette decode
-                        frame_decoder = _Decoder0x1AFrame(
-                            frame_data,
-                            width=width,
-                            height=height,
-                            debug=False,
-                            frame_index=frame_idx,
-                            previous_palette=shared_palette,
-                        )
-                        img, _ = frame_decoder.decode_frame()
-                        frames_rgb.append(img.tobytes())
-                        # Persist updated palette
-                        shared_palette = frame_decoder.palette
-                    else:
-                        # Unsupported inside this container; try hierarchical as fallback
-                        frame_decoder = _Decoder0x1AFrame(
-                            frame_data,
-                            width=width,
-                            height=height,
-                            debug=False,
-                            frame_index=frame_idx,
-                            previous_palette=shared_palette,
-                        )
-                        img, _ = frame_decoder.decode_frame()
-                        frames_rgb.append(img.tobytes())
-                        shared_palette = frame_decoder.palette
-
-                    # Move to next frame (skip the 4-byte header we already accounted for + payload)
-                    pos = idx + payload_len
-
-                except (IndexError, ValueError) as e:
-                    # Frame has incomplete or invalid data
-                    # Duplicate previous frame if available, otherwise create blank frame
-                    if frames_rgb:
-                        frames_rgb.append(frames_rgb[-1])
-                    else:
-                        # Create blank frame with correct dimensions
-                        blank_img = Image.new('RGB', (width, height), (0, 0, 0))
-                        frames_rgb.append(blank_img.tobytes())
-                    # Try to move to next frame using payload_len if we got that far
-                    try:
-                        if 'payload_len' in locals():
-                            pos = idx + payload_len
-                        else:
-                            break  # Can't continue without knowing frame size
-                    except:
-                        break
+            # Decode 0x11/0x13/0x15 format frames (with 0xAA marker): a cheap scan fixes
+            # every frame's bounds and palette, then the palette frames decode (optionally
+            # concurrently on ``executor``) and are assembled in order.
+            slots = _scan_0x1a_frames(all_frame_data, total_frames_declared, width, height)
+            plan = self._ctx.plan(FileFormat.ANIM_MULTIPLE_64, width, height)
+            predecoded = None
+            if self._executor is not None:
+                jobs = [(all_frame_data[s.start:s.end], width, height, s.index, s.palette_in,
+                         plan) for s in slots if s.kind == _SLOT_PALETTE]
+                predecoded = iter(self._executor.map(_decode_0x1a_frame_job, jobs))
+            frames_rgb = _assemble_0x1a_frames(all_frame_data, slots, width, height, predecoded,
+                                               plan)
         
         frames_decoded = len(frames_rgb)
 
@@ -542,6 +610,7 @@ class _Decoder0x1AFrame:
         debug: bool = False,
         frame_index: int = 0,
         previous_palette: List[Tuple[int, int, int]] = None,
+        plan: '_DecodePlan' = None,
     ):
         # Parse per-frame header
         if len(frame_data) < 8:
@@ -553,31 +622,7 @@ class _Decoder0x1AFrame:
         # Accept high-bit variant per native code
         self.encrypt_type = frame_data[5] & 0x7F
 
-        # Palette size is 16-bit little-endian at offset 6
-        palette_size_u16 = frame_data[6] | (frame_data[7] << 8)
-        palette_start = 8
-        # Build or extend palette according to encrypt_type
-        base_palette: List[Tuple[int, int, int]] = previous_palette or []
-        self.palette: List[Tuple[int, int, int]] = []
-        if self.encrypt_type == 0x13:
-            # Append new colors to previous palette
-            self.palette = list(base_palette)
-            for i in range(palette_size_u16):
-                off = palette_start + i * 3
-                if off + 2 >= len(frame_data):
-                    raise ValueError(f"Palette OOB at {off} len={len(frame_data)}")
-                r, g, b = frame_data[off], frame_data[off + 1], frame_data[off + 2]
-                self.palette.append((r, g, b))
-            pixel_data_offset = palette_start + palette_size_u16 * 3
-        else:
-            # Full palette provided (e.g., 0x15)
-            for i in range(palette_size_u16):
-                off = palette_start + i * 3
-                if off + 2 >= len(frame_data):
-                    raise ValueError(f"Palette OOB at {off} len={len(frame_data)}")
-                r, g, b = frame_data[off], frame_data[off + 1], frame_data[off + 2]
-                self.palette.append((r, g, b))
-            pixel_data_offset = palette_start + palette_size_u16 * 3
+        self.palette, pixel_data_offset = self.parse_palette(frame_data, previous_palette)
         self.pixel = frame_data[pixel_data_offset:]
         self.pixel_data_offset = pixel_data_offset
         self._out_of_data_warning = False
@@ -587,18 +632,67 @@ class _Decoder0x1AFrame:
         # Output buffer (scanline order) with actual dimensions
         self.width = width
         self.height = height
-        self.out: List[Tuple[int, int, int]] = [(0, 0, 0)] * (self.width * self.height)
+        self.out = np.zeros((self.width * self.height, 3), dtype=np.uint8)
+        self._palette_rgb = np.array(self.palette, dtype=np.uint8).reshape(-1, 3)
+        self._plan = plan or DecoderContext.for_thread().plan(FileFormat.ANIM_MULTIPLE_64, width, height)
+        self._dry_run = False  # validate(): walk headers/bounds only, skip pixel values
         # Bitstream is little-endian within each byte
         self._bitorder = 'lsb'
         self._debug = debug
         self._frame_index = frame_index
 
-    def _palette_at(self, idx: int) -> Tuple[int, int, int]:
-        if not (0 <= idx < len(self.palette)):
-            idx = 0
-        return self.palette[idx]
+    @staticmethod
+    def parse_palette(
+        frame_data: bytes, previous_palette: List[Tuple[int, int, int]] = None
+    ) -> Tuple[List[Tuple[int, int, int]], int]:
+        """Return ``(palette, pixel_data_offset)`` for a frame, without touching its pixels.
+
+        0x13 frames append their colours to ``previous_palette``; every other type carries
+        a full palette. Raises ``ValueError`` if the palette runs past the frame.
+        """
+        # Palette size is 16-bit little-endian at offset 6
+        palette_size_u16 = frame_data[6] | (frame_data[7] << 8)
+        palette_start = 8
+        pixel_data_offset = palette_start + palette_size_u16 * 3
+        if pixel_data_offset > len(frame_data):
+            raise ValueError(f"Palette OOB: {palette_size_u16} colors, len={len(frame_data)}")
+        colors = [tuple(frame_data[off:off + 3])
+                  for off in range(palette_start, pixel_data_offset, 3)]
+        if frame_data[5] & 0x7F == 0x13:
+            # Append new colors to previous palette
+            return list(previous_palette or []) + colors, pixel_data_offset
+        # Full palette provided (e.g., 0x15)
+        return colors, pixel_data_offset
+
+    def _paint(self, size: int, x0: int, y0: int, values: List[int],
+               lut: List[int] = None, fallback: int = 0) -> None:
+        """Scatter a ``size``x``size`` node's pixels into ``out`` along the plan's 8x8 walk.
+
+        ``values`` index ``lut`` (or the palette directly when ``lut`` is None); indices past
+        the end of ``lut`` resolve to ``fallback``, then palette misses resolve to entry 0.
+        """
+        dest = y0 * self.width + x0 + self._plan.node_offsets(size)
+        if self._dry_run:
+            if not len(self._palette_rgb) or dest[-1] >= len(self.out):
+                raise IndexError("Node does not fit the frame or palette is empty")
+            return
+        idx = np.asarray(values, dtype=np.intp)
+        if lut is not None:
+            if lut:
+                lut_arr = np.asarray(lut, dtype=np.intp)
+                hit = idx < len(lut_arr)
+                idx = np.where(hit, lut_arr[np.where(hit, idx, 0)], fallback)
+            else:
+                idx = np.full(idx.shape, fallback, dtype=np.intp)
+        if not len(self._palette_rgb):
+            raise IndexError("Empty palette")
+        idx = np.where(idx < len(self._palette_rgb), idx, 0)
+        self.out[dest] = self._palette_rgb[idx]
 
     def _read_indices(self, data: bytes, start: int, num_values: int, bits: int) -> Tuple[List[int], int]:
+        if self._dry_run:
+            # Only the stream position matters; short data is zero-padded, never an error
+            return None, start + (num_values * bits + 7) // 8
         if bits == 0:
             return [0] * num_values, start
         if self._bitorder == 'lsb':
@@ -686,37 +780,14 @@ class _Decoder0x1AFrame:
                 print(f"  [64] ctrl=2 selected={len(selected)} bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 64 * 64, bpp)
             # Paint in 8×8 subtiles (Morton-style nested loops in C)
-            it = 0
-            w = self.width
-            for br in range(8):
-                for bc in range(8):
-                    for row in range(8):
-                        y = y0 + br * 8 + row
-                        base = y * w + (x0 + bc * 8)
-                        for col in range(8):
-                            idx = values[it]
-                            it += 1
-                            if not (0 <= idx < len(selected)):
-                                idx = 0
-                            self.out[base + col] = self._palette_at(selected[idx])
+            self._paint(64, x0, y0, values, selected, fallback=selected[0])
             return ptr2 - offset
         elif ctrl == 0:
             bpp = self.base_bpp
             if self._debug:
                 print(f"  [64] ctrl=0 bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 64 * 64, bpp)
-            it = 0
-            w = self.width
-            for br in range(8):
-                for bc in range(8):
-                    for row in range(8):
-                        y = y0 + br * 8 + row
-                        base = y * w + (x0 + bc * 8)
-                        for col in range(8):
-                            idx = values[it]
-                            it += 1
-                            pal_index = idx if 0 <= idx < len(self.palette) else 0
-                            self.out[base + col] = self._palette_at(pal_index)
+            self._paint(64, x0, y0, values)
             return ptr2 - offset
         else:
             # Recursion with a mask into the base palette
@@ -765,36 +836,14 @@ class _Decoder0x1AFrame:
             if self._debug:
                 print(f"    [32] ctrl=2 selected={len(selected)} bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 32 * 32, bpp)
-            it = 0
-            w = self.width
-            for br in range(4):
-                for bc in range(4):
-                    for row in range(8):
-                        y = y0 + br * 8 + row
-                        base = y * w + (x0 + bc * 8)
-                        for col in range(8):
-                            idx = values[it]
-                            it += 1
-                            pal_index = selected[idx] if 0 <= idx < len(selected) else 0
-                            self.out[base + col] = self._palette_at(pal_index)
+            self._paint(32, x0, y0, values, selected)
             return ptr2 - offset
         elif ctrl == 0:
             bpp = self._bits_per_pixel_from_count(len(parent_map) or 1)
             if self._debug:
                 print(f"    [32] ctrl=0 parent_len={len(parent_map)} bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 32 * 32, bpp)
-            it = 0
-            w = self.width
-            for br in range(4):
-                for bc in range(4):
-                    for row in range(8):
-                        y = y0 + br * 8 + row
-                        base = y * w + (x0 + bc * 8)
-                        for col in range(8):
-                            idx = values[it]
-                            it += 1
-                            pal_index = parent_map[idx] if 0 <= idx < len(parent_map) else 0
-                            self.out[base + col] = self._palette_at(pal_index)
+            self._paint(32, x0, y0, values, parent_map)
             return ptr2 - offset
         else:
             mask_bytes = (N + 7) // 8
@@ -848,38 +897,15 @@ class _Decoder0x1AFrame:
             if self._debug:
                 print(f"      [16] ctrl=2 selected={len(selected)} bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 16 * 16, bpp)
-            it = 0
-            w = self.width
-            for row_block in range(2):  # top, bottom
-                for band in range(2):   # left, right
-                    x_band = x0 + band * 8
-                    for row in range(8):
-                        y = y0 + row_block * 8 + row
-                        base = y * w + x_band
-                        for col in range(8):
-                            idx = values[it]
-                            it += 1
-                            pal_index = selected[idx] if 0 <= idx < len(selected) else 0
-                            self.out[base + col] = self._palette_at(pal_index)
+            # Paint top/bottom row blocks, each as left/right 8-px bands
+            self._paint(16, x0, y0, values, selected)
             return ptr2 - offset
         elif ctrl == 0:
             bpp = self._bits_per_pixel_from_count(len(parent_map) or 1)
             if self._debug:
                 print(f"      [16] ctrl=0 parent_len={len(parent_map)} bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 16 * 16, bpp)
-            it = 0
-            w = self.width
-            for row_block in range(2):
-                for band in range(2):
-                    x_band = x0 + band * 8
-                    for row in range(8):
-                        y = y0 + row_block * 8 + row
-                        base = y * w + x_band
-                        for col in range(8):
-                            idx = values[it]
-                            it += 1
-                            pal_index = parent_map[idx] if 0 <= idx < len(parent_map) else 0
-                            self.out[base + col] = self._palette_at(pal_index)
+            self._paint(16, x0, y0, values, parent_map)
             return ptr2 - offset
         else:
             mask_bytes = (N + 7) // 8
@@ -927,15 +953,7 @@ class _Decoder0x1AFrame:
                 print(f"        [8] mask hdr N={N} bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 8 * 8, bpp)
             # Paint contiguous 8×8
-            it = 0
-            w = self.width
-            for row in range(8):
-                base = (y0 + row) * w + x0
-                for col in range(8):
-                    idx = values[it]
-                    it += 1
-                    pal_index = selected[idx] if 0 <= idx < len(selected) else 0
-                    self.out[base + col] = self._palette_at(pal_index)
+            self._paint(8, x0, y0, values, selected)
             return ptr2 - offset
         else:
             bpp = self._bits_per_pixel_from_count(len(parent_map))
@@ -943,21 +961,13 @@ class _Decoder0x1AFrame:
             if self._debug:
                 print(f"        [8] raw hdr bpp={bpp} read_from={ptr}")
             values, ptr2 = self._read_indices(self.pixel, ptr, 8 * 8, bpp)
-            it = 0
-            w = self.width
-            for row in range(8):
-                base = (y0 + row) * w + x0
-                for col in range(8):
-                    idx = values[it]
-                    it += 1
-                    pal_index = parent_map[idx] if 0 <= idx < len(parent_map) else 0
-                    self.out[base + col] = self._palette_at(pal_index)
+            self._paint(8, x0, y0, values, parent_map)
             return ptr2 - offset
 
-    def decode_frame(self) -> Tuple[Image.Image, int]:
+    def _walk(self) -> int:
         """
-        Decode a single frame and return the image and bytes consumed.
-        
+        Decode the quadtree into ``out`` and return the pixel bytes consumed.
+
         For 64x64 frames: decode only the top-left 64x64 quadrant
         For 128x128 frames: decode all four 64x64 quadrants
         """
@@ -971,16 +981,177 @@ class _Decoder0x1AFrame:
             off += self._decode_fix_64(off, 1, 0)  # Top-right
             off += self._decode_fix_64(off, 0, 1)  # Bottom-left
             off += self._decode_fix_64(off, 1, 1)  # Bottom-right
-        
-        img = Image.new('RGB', (self.width, self.height))
-        img.putdata(self.out)
+        return off
+
+    def validate(self) -> bool:
+        """Return whether :meth:`decode_frame` would succeed, without reading pixel values.
+
+        Walks every node header and mask with the same bounds checks, which is far cheaper
+        than a full decode. Used to build exact palette checkpoints for seeking.
+        """
+        self._dry_run = True
+        try:
+            self._walk()
+        except (IndexError, ValueError):
+            return False
+        finally:
+            self._dry_run = False
+        return True
+
+    def decode_frame(self) -> Tuple[Image.Image, int]:
+        """Decode a single frame and return the image and bytes consumed."""
+        off = self._walk()
+        img = Image.fromarray(self.out.reshape(self.height, self.width, 3), 'RGB')
         if self._debug:
             total_payload = len(self.pixel) + self.pixel_data_offset
             print(f"  [frame] pixel-bytes consumed: {off} / {len(self.pixel)} | total payload used: {self.pixel_data_offset + off} / {total_payload}")
         return img, off
 
 
+# 0xAA-framed 0x1A containers: scan pass (bounds + palettes) and in-order assembly.
+_SLOT_BAD, _SLOT_RAW, _SLOT_PALETTE = range(3)
+
+
+class _FrameSlot(NamedTuple):
+    """One frame found by :func:`_scan_0x1a_frames`."""
+    kind: int  # _SLOT_BAD (known-invalid), _SLOT_RAW (0x11) or _SLOT_PALETTE (0x13/0x15/...)
+    index: int
+    start: int  # offset of the 0xAA marker in the container payload
+    end: int
+    appends: bool = False  # 0x13: palette extends the previous frame's
+    palette_in: List[Tuple[int, int, int]] = None
+    palette_out: List[Tuple[int, int, int]] = None
+
+
+def _scan_0x1a_frames(data: bytes, total_frames: int, width: int, height: int,
+                      validate: bool = False, plan: _DecodePlan = None) -> List[_FrameSlot]:
+    """Walk the ``[4-byte header][0xAA][u16 LE payload_len]...`` chain without decoding pixels.
+
+    Frame bounds depend only on the headers, so this fixes every frame's slice and replays
+    the palette sections to get each frame's input palette. The palettes are speculative:
+    a palette frame whose pixel walk later fails leaves the running palette unchanged,
+    which :func:`_assemble_0x1a_frames` detects and corrects. With ``validate`` each
+    palette frame is also dry-run (:meth:`_Decoder0x1AFrame.validate`) with ``plan``,
+    making them exact.
+    """
+    slots: List[_FrameSlot] = []
+    palette: List[Tuple[int, int, int]] = []
+    raw_size = width * height * 3
+    payload_len = None
+    pos = 0
+    for frame_idx in range(total_frames):
+        # Skip 4-byte frame header, then find 0xAA marker
+        idx = pos + 4
+        if pos >= len(data) or idx >= len(data):
+            break
+        if data[idx] != 0xAA:
+            slots.append(_FrameSlot(_SLOT_BAD, frame_idx, idx, idx))
+            if payload_len is None:
+                break  # Can't continue without knowing frame size
+            pos = idx + payload_len  # resync using the previous frame's length
+            continue
+        if idx + 2 >= len(data):
+            break
+        # Read payload length (2 bytes, little-endian)
+        payload_len = data[idx + 1] | (data[idx + 2] << 8)
+        end = min(idx + payload_len, len(data))
+        pos = idx + payload_len
+        if end - idx < 8:
+            slots.append(_FrameSlot(_SLOT_BAD, frame_idx, idx, end))  # truncated header
+            continue
+        encrypt_type = data[idx + 5] & 0x7F  # accept high-bit variants
+        if encrypt_type == 0x11:
+            # Raw RGB; resets palette persistence
+            kind = _SLOT_RAW if end - idx >= 8 + raw_size else _SLOT_BAD
+            slots.append(_FrameSlot(kind, frame_idx, idx, end))
+            if kind == _SLOT_RAW:
+                palette = []
+            continue
+        try:
+            if validate:
+                frame_decoder = _Decoder0x1AFrame(data[idx:end], width, height,
+                                                  frame_index=frame_idx, previous_palette=palette,
+                                                  plan=plan)
+                if not frame_decoder.validate():
+                    raise ValueError("Invalid quadtree")
+                palette_out = frame_decoder.palette
+            else:
+                palette_out, _ = _Decoder0x1AFrame.parse_palette(data[idx:end], palette)
+        except ValueError:
+            slots.append(_FrameSlot(_SLOT_BAD, frame_idx, idx, end))
+            continue
+        slots.append(_FrameSlot(_SLOT_PALETTE, frame_idx, idx, end,
+                                encrypt_type == 0x13, palette, palette_out))
+        palette = palette_out
+    return slots
+
+
+def _decode_0x1a_frame_job(job) -> Optional[Tuple[bytes, List[Tuple[int, int, int]]]]:
+    """Decode one palette frame: ``(frame_data, width, height, index, palette, plan)`` -> ``(rgb, palette)``.
+
+    ``plan`` may be None (the thread's own). Returns None if the frame is invalid.
+    Module-level so process pools can pickle it.
+    """
+    frame_data, width, height, frame_index, previous_palette, plan = job
+    try:
+        frame_decoder = _Decoder0x1AFrame(
+            frame_data,
+            width=width,
+            height=height,
+            debug=False,
+            frame_index=frame_index,
+            previous_palette=previous_palette,
+            plan=plan,
+        )
+        kernel = _KERNELS.get('decode_0x1a_pixels')
+        if kernel is not None:
+            rgb = kernel(frame_decoder.pixel, width, height, frame_decoder._palette_rgb.tobytes())
+            return None if rgb is None else (bytes(rgb), frame_decoder.palette)
+        img, _ = frame_decoder.decode_frame()
+    except (IndexError, ValueError):
+        return None
+    return img.tobytes(), frame_decoder.palette
+
+
+def _assemble_0x1a_frames(data: bytes, slots: List[_FrameSlot], width: int, height: int,
+                          predecoded=None, plan: _DecodePlan = None) -> List[bytes]:
+    """Produce frames in order from scanned slots, exactly as a sequential decode would.
+
+    ``predecoded`` optionally yields a :func:`_decode_0x1a_frame_job` result per palette slot,
+    computed from the scan's speculative palettes. A 0x13 result is only used when its
+    input palette matches the running one; otherwise that frame is decoded again here.
+    Invalid frames duplicate the previous frame (or are black if there is none).
+    """
+    frames_rgb: List[bytes] = []
+    palette: List[Tuple[int, int, int]] = []
+    raw_size = width * height * 3
+    for slot in slots:
+        result = None
+        if slot.kind == _SLOT_RAW:
+            frames_rgb.append(bytes(data[slot.start + 8:slot.start + 8 + raw_size]))
+            palette = []
+            continue
+        if slot.kind == _SLOT_PALETTE:
+            result = next(predecoded) if predecoded is not None else None
+            stale = slot.appends and palette is not slot.palette_in and palette != slot.palette_in
+            if predecoded is None or stale:
+                result = _decode_0x1a_frame_job(
+                    (data[slot.start:slot.end], width, height, slot.index, palette, plan))
+            elif result is not None:
+                result = (result[0], slot.palette_out)  # keep identity for the next check
+        if result is None:
+            # Frame has incomplete or invalid data: duplicate previous frame if available,
+            # otherwise create blank frame
+            frames_rgb.append(frames_rgb[-1] if frames_rgb else bytes(raw_size))
+            continue
+        frames_rgb.append(result[0])
+        palette = result[1]
+    return frames_rgb
+
+
 class PicMultiDecoder(BaseDecoder):
+    FORMAT = FileFormat.PIC_MULTIPLE
+
     def decode(self) -> PixelBean:
         row_count, column_count, length = unpack('>BBI', self._fp.read(6))
         encrypted_data = self._fp.read()
@@ -1014,18 +1185,14 @@ class AnimZstdRawRGBDecoder(BaseDecoder):
         total_frames, speed, row_count, column_count = unpack('>BHBB', self._fp.read(5))
         width = 16 * column_count
         height = 16 * row_count
-        remainder = self._fp.read()
+        remainder = bytes(self._fp.read())
         # Find zstd payload and decompress
         magic = b'\x28\xB5\x2F\xFD'
         idx = remainder.find(magic)
         if idx == -1:
             raise Exception('Format 42: zstd magic not found')
         payload = remainder[idx:]
-        try:
-            import zstandard as zstd
-        except Exception:
-            raise Exception('Format 42 requires zstandard package')
-        decomp = zstd.ZstdDecompressor().decompress(payload)
+        decomp = self._ctx.zstd.decompress(payload)
         frame_bytes = width * height * 3
         if frame_bytes == 0:
             raise Exception('Invalid dimensions')
@@ -1071,7 +1238,7 @@ class AnimEmbeddedImageDecoder(BaseDecoder):
         total_frames, speed, row_count, column_count = unpack('>BHBB', self._fp.read(5))
         width = 16 * column_count
         height = 16 * row_count
-        data = self._fp.read()
+        data = bytes(self._fp.read())
         frames_rgb = self._extract_frames_rgb(data, width, height)
         frames_arrays = _frames_from_rgb(frames_rgb, width, height)
         return PixelBean(
@@ -1109,7 +1276,7 @@ class Format41Decoder(BaseDecoder):
         width = column_count * 16
         height = row_count * 16
 
-        payload = self._fp.read()
+        payload = bytes(self._fp.read())
         if not payload:
             logger.error("Format 41: empty payload")
             return None
@@ -1201,24 +1368,16 @@ class Format41Decoder(BaseDecoder):
 class AnimMulti64Decoder(BaseDecoder):
     """Decoder specifically for 64x64 animations with 0x0C encryption (format 26)."""
 
+    FORMAT = FileFormat.ANIM_MULTIPLE_64
+
     def decode(self) -> PixelBean:
         """Decode 64x64 animation and return a PixelBean."""
         total_frames_declared, speed, row_count, column_count = unpack('>BHBB', self._fp.read(5))
 
-        frames_data = []
-
-        for frame in range(total_frames_declared):
-            size_bytes = self._fp.read(4)
-            if len(size_bytes) < 4:
-                break
-
-            size = unpack('>I', size_bytes)[0]
-            frame_raw_data = self._fp.read(size)
-
-            if len(frame_raw_data) < size:
-                break
-
-            frames_data.append(_decode_0x0c_frame(frame_raw_data))
+        # Read the size-prefixed frame table first; 0x0C frames each carry their own
+        # palette, so they decode independently (concurrently when given an executor).
+        frames_raw = _split_size_prefixed(self._fp.read(), total_frames_declared)
+        frames_data = list(_map_frames(self._executor, _decode_0x0c_frame, frames_raw))
 
         frames_decoded = len(frames_data)
 
@@ -1333,7 +1492,7 @@ class Decoder0x1F(BaseDecoder):
         height = row_count * 16
         
         # Read all remaining payload (contains JPEG frames)
-        payload = self._fp.read()
+        payload = bytes(self._fp.read())
         
         # Extract and decode JPEG frames
         frames_rgb = self._extract_jpeg_frames(payload, width, height, total_frames)
@@ -1358,7 +1517,213 @@ class Decoder0x1F(BaseDecoder):
         )
 
 
-def _decode_format_26(fp: IOBase) -> PixelBean:
+# --------------------------------------------------------------------------- #
+# Random access: per-file frame seek index
+# --------------------------------------------------------------------------- #
+class FrameSeekIndex:
+    """Frame offsets plus palette checkpoints for decoding single frames of a file.
+
+    Built in one pass by :meth:`PixelBeanDecoder.build_frame_index` (no pixel decoding).
+    Layouts:
+
+    * ``'0x1a'`` — 0xAA-framed format 26: ``frames`` holds ``[kind, start, end, appends]``
+      per frame (absolute file offsets) and ``checkpoints`` the running palette entering
+      every ``checkpoint_every``-th frame, so frame ``k`` replays at most that many palette
+      sections before decoding only itself.
+    * ``'0x0c'`` / ``'0x0c64'`` — independent 0x0C frames (format 26 via ``Decoder0x1A`` /
+      ``AnimMulti64Decoder``): ``frames`` holds ``[kind, start, end, False]``.
+    * ``'full'`` — any other format: no random access, the whole file is decoded.
+
+    ``file_size`` guards against applying an index to a different file. Persist with
+    :meth:`save`/:meth:`load`, e.g. as a ``<file>.idx.json`` sidecar (:meth:`sidecar_path`).
+    """
+
+    VERSION = 1
+
+    def __init__(self, fmt: int, layout: str, width: int, height: int, speed: int,
+                 file_size: int, frames=None, checkpoints=None, checkpoint_every: int = 32,
+                 total_frames: int = 0):
+        self.format = fmt
+        self.layout = layout
+        self.width = width
+        self.height = height
+        self.speed = speed
+        self.file_size = file_size
+        self.frames = frames or []
+        self.checkpoints = checkpoints or {}
+        self.checkpoint_every = checkpoint_every
+        self.total_frames = len(self.frames) if self.frames else total_frames
+
+    @staticmethod
+    def sidecar_path(file_path: str) -> str:
+        return file_path + '.idx.json'
+
+    def to_dict(self) -> dict:
+        return {
+            'version': self.VERSION, 'format': self.format, 'layout': self.layout,
+            'width': self.width, 'height': self.height, 'speed': self.speed,
+            'file_size': self.file_size, 'total_frames': self.total_frames,
+            'checkpoint_every': self.checkpoint_every, 'frames': self.frames,
+            'checkpoints': {str(k): bytes(c for rgb in pal for c in rgb).hex()
+                            for k, pal in self.checkpoints.items()},
+        }
+
+    @classmethod
+    def from_dict(cls, d: dict) -> 'FrameSeekIndex':
+        if d.get('version') != cls.VERSION:
+            raise ValueError(f"Unsupported frame index version: {d.get('version')}")
+        checkpoints = {}
+        for k, hexed in d['checkpoints'].items():
+            raw = bytes.fromhex(hexed)
+            checkpoints[int(k)] = [tuple(raw[i:i + 3]) for i in range(0, len(raw), 3)]
+        return cls(d['format'], d['layout'], d['width'], d['height'], d['speed'],
+                   d['file_size'], [list(f) for f in d['frames']], checkpoints,
+                   d['checkpoint_every'], d['total_frames'])
+
+    def save(self, path: str) -> None:
+        import json
+        with open(path, 'w', encoding='utf-8') as fh:
+            json.dump(self.to_dict(), fh, separators=(',', ':'))
+
+    @classmethod
+    def load(cls, path: str) -> 'FrameSeekIndex':
+        import json
+        with open(path, 'r', encoding='utf-8') as fh:
+            return cls.from_dict(json.load(fh))
+
+
+def _build_frame_index(fp: IOBase, checkpoint_every: int = 32,
+                       context: DecoderContext = None) -> FrameSeekIndex:
+    data = fp.read()
+    if len(data) < 6:
+        raise ValueError('Stream too short for a frame index')
+    fmt = data[0]
+    total_frames, speed, row_count, column_count = unpack('>BHBB', data[1:6])
+    width, height = column_count * 16, row_count * 16
+    payload = data[6:]
+    if fmt != FileFormat.ANIM_MULTIPLE_64.value:
+        return FrameSeekIndex(fmt, 'full', width, height, speed, len(data),
+                              total_frames=total_frames)
+
+    if width == 64 and height == 64 or Decoder0x1A.uses_0x0c_frames(payload):
+        layout = '0x0c64' if width == 64 and height == 64 else '0x0c'
+        frames = []
+        pos = 0
+        for raw in _split_size_prefixed(payload, total_frames):
+            start = 6 + pos + 4
+            pos += 4 + len(raw)
+            valid = len(raw) >= 8 and raw[5] == 0x0C
+            frames.append([_SLOT_PALETTE if valid else _SLOT_BAD, start, start + len(raw), False])
+            if not valid and layout == '0x0c':
+                break  # Decoder0x1A stops after duplicating the first bad frame
+        return FrameSeekIndex(fmt, layout, width, height, speed, len(data), frames)
+
+    plan = (context or DecoderContext.for_thread()).plan(FileFormat.ANIM_MULTIPLE_64,
+                                                         width, height)
+    slots = _scan_0x1a_frames(payload, total_frames, width, height, validate=True, plan=plan)
+    frames = [[s.kind, 6 + s.start, 6 + s.end, s.appends] for s in slots]
+    checkpoints = {}
+    running: List[Tuple[int, int, int]] = []
+    for i, s in enumerate(slots):
+        if i % checkpoint_every == 0:
+            checkpoints[i] = list(running)
+        if s.kind == _SLOT_RAW:
+            running = []
+        elif s.kind == _SLOT_PALETTE:
+            running = s.palette_out
+    return FrameSeekIndex(fmt, '0x1a', width, height, speed, len(data), frames, checkpoints,
+                          checkpoint_every)
+
+
+def _read_span(fp: IOBase, start: int, end: int) -> bytes:
+    fp.seek(start)
+    return fp.read(end - start)
+
+
+def _decode_indexed_frame(fp: IOBase, k: int, index: FrameSeekIndex,
+                          context: DecoderContext = None) -> np.ndarray:
+    fp.seek(0, io.SEEK_END)
+    if fp.tell() != index.file_size:
+        raise ValueError('Frame index does not match this file (size differs)')
+    if not 0 <= k < index.total_frames:
+        raise IndexError(f'Frame {k} out of range (0..{index.total_frames - 1})')
+    width, height = index.width, index.height
+
+    if index.layout == 'full':
+        fp.seek(0)
+        return PixelBeanDecoder.decode_stream(fp, context=context).frames_data[k]
+
+    if index.layout == '0x0c64':
+        # AnimMulti64Decoder fails the whole file on a bad frame, so every frame raises too
+        bad = next((f for f in index.frames if f[0] == _SLOT_BAD), None)
+        if bad is not None:
+            _decode_0x0c_frame(_read_span(fp, bad[1], bad[2]))  # the full decode's exception
+            raise ValueError('Format 26 64x64 file has a corrupt frame')
+
+    # Invalid frames repeat the previous good one (black if there is none)
+    while k >= 0 and index.frames[k][0] == _SLOT_BAD:
+        k -= 1
+    if k < 0:
+        return np.zeros((height, width, 3), dtype=np.uint8)
+    kind, start, end, _ = index.frames[k]
+    frame = _read_span(fp, start, end)
+
+    if index.layout == '0x0c64':
+        decoder = AnimMulti64Decoder(io.BytesIO(), context=context)
+        return decoder._compact([_decode_0x0c_frame(frame)], 1, height // 16, width // 16)[0]
+    if index.layout == '0x0c':
+        return _frames_from_rgb([_decode_0x0c_frame(frame)], width, height)[0]
+    if kind == _SLOT_RAW:
+        return _frames_from_rgb([frame[8:8 + width * height * 3]], width, height)[0]
+
+    # Replay palette sections from the nearest checkpoint up to frame k
+    first = k - k % index.checkpoint_every
+    palette = index.checkpoints.get(first, [])
+    for j in range(first, k):
+        j_kind, j_start, j_end, _ = index.frames[j]
+        if j_kind == _SLOT_RAW:
+            palette = []
+        elif j_kind == _SLOT_PALETTE:
+            palette, _ = _Decoder0x1AFrame.parse_palette(_read_span(fp, j_start, j_end), palette)
+    plan = (context or DecoderContext.for_thread()).plan(FileFormat.ANIM_MULTIPLE_64,
+                                                         width, height)
+    result = _decode_0x1a_frame_job((frame, width, height, k, palette, plan))
+    if result is None:
+        raise ValueError(f'Frame {k} failed to decode; the index may be stale')
+    return _frames_from_rgb([result[0]], width, height)[0]
+
+
+class FileHeader(NamedTuple):
+    """Dimensions read from a file header without decoding it (see :meth:`PixelBeanDecoder.probe`)."""
+    format: FileFormat
+    total_frames: int
+    width: int
+    height: int
+
+    @property
+    def raw_bytes(self) -> int:
+        """Size of the decoded RGB frames."""
+        return self.total_frames * self.width * self.height * 3
+
+
+def _probe_header(head: bytes, file_size: int) -> Optional[FileHeader]:
+    if len(head) < 7:
+        return None
+    try:
+        fmt = FileFormat(head[0])
+    except ValueError:
+        return None
+    if fmt == FileFormat.ANIM_SINGLE:  # 16x16 AES frames after a 4-byte header
+        return FileHeader(fmt, max(1, (file_size - 4) // 768), 16, 16)
+    if fmt == FileFormat.PIC_MULTIPLE:  # rows, cols, length; always one frame
+        return FileHeader(fmt, 1, head[2] * 16, head[1] * 16)
+    frames, rows, cols = head[1], head[4], head[5]
+    if fmt == FileFormat.ANIM_FORMAT_0x29:
+        rows, cols = rows or 1, cols or 1
+    return FileHeader(fmt, max(1, frames), cols * 16, rows * 16)
+
+
+def _decode_format_26(fp: IOBase, executor=None, context=None) -> PixelBean:
     """Format 26 routes by canvas size: 64x64 uses the 0x0C decoder, larger uses 0x1A."""
     header = fp.read(5)
     if len(header) < 5:
@@ -1366,35 +1731,113 @@ def _decode_format_26(fp: IOBase) -> PixelBean:
     width = header[4] * 16
     height = header[3] * 16
     logger.info('File format 26 (%dx%d)', width, height)
-    stream = io.BytesIO(header + fp.read())
+    stream = io.BytesIO(bytes(header) + fp.read())
     if width == 64 and height == 64:
-        return AnimMulti64Decoder(stream).decode()
-    return Decoder0x1A(stream).decode()
+        return AnimMulti64Decoder(stream, executor, context).decode()
+    return Decoder0x1A(stream, executor, context).decode()
 
 
-# Format byte -> callable(fp) -> PixelBean.
+# Format byte -> callable(fp, executor, context) -> PixelBean.
 _DECODERS = {
-    FileFormat.ANIM_SINGLE: lambda fp: AnimSingleDecoder(fp).decode(),
-    FileFormat.ANIM_MULTIPLE: lambda fp: AnimMultiDecoder(fp).decode(),
-    FileFormat.PIC_MULTIPLE: lambda fp: PicMultiDecoder(fp).decode(),
+    FileFormat.ANIM_SINGLE: lambda fp, ex, ctx: AnimSingleDecoder(fp, ex, ctx).decode(),
+    FileFormat.ANIM_MULTIPLE: lambda fp, ex, ctx: AnimMultiDecoder(fp, ex, ctx).decode(),
+    FileFormat.PIC_MULTIPLE: lambda fp, ex, ctx: PicMultiDecoder(fp, ex, ctx).decode(),
     FileFormat.ANIM_MULTIPLE_64: _decode_format_26,
-    FileFormat.ANIM_FORMAT_0x29: lambda fp: Format41Decoder(fp).decode(),
-    FileFormat.ANIM_FORMAT_0x1F: lambda fp: Decoder0x1F(fp).decode(),
-    FileFormat.ANIM_CONTAINER_ZSTD: lambda fp: AnimZstdRawRGBDecoder(fp).decode(),
-    FileFormat.ANIM_EMBEDDED_IMAGE: lambda fp: AnimEmbeddedImageDecoder(fp).decode(),
+    FileFormat.ANIM_FORMAT_0x29: lambda fp, ex, ctx: Format41Decoder(fp, ex, ctx).decode(),
+    FileFormat.ANIM_FORMAT_0x1F: lambda fp, ex, ctx: Decoder0x1F(fp, ex, ctx).decode(),
+    FileFormat.ANIM_CONTAINER_ZSTD: lambda fp, ex, ctx: AnimZstdRawRGBDecoder(fp, ex, ctx).decode(),
+    FileFormat.ANIM_EMBEDDED_IMAGE: lambda fp, ex, ctx: AnimEmbeddedImageDecoder(fp, ex, ctx).decode(),
 }
 
 
 class PixelBeanDecoder:
-    """Dispatch a Divoom pixel file to the decoder registered for its format byte."""
+    """Dispatch a Divoom pixel file to the decoder registered for its format byte.
+
+    ``executor`` (optional ``concurrent.futures.Executor``) lets decoders that support it
+    decode frames concurrently; output is identical to the default inline decode. A
+    ``ProcessPoolExecutor`` gives real speedup for the pure-Python frame kernels.
+
+    ``context`` (optional :class:`DecoderContext`) supplies codec objects and decode
+    plans; by default each thread uses its own, so files may be decoded from many threads
+    at once.
+
+    ``cache`` (optional, e.g. :class:`servoom.frame_cache.FrameCache`) serves repeat
+    decodes of identical file content from its store and fills it on a miss.
+    """
+
+    @staticmethod
+    def decode_file(file_path: str, executor=None, context: DecoderContext = None,
+                    cache=None) -> PixelBean:
+        if cache is not None:
+            return cache.decode_file(file_path, executor=executor, context=context)
+        with open(file_path, 'rb') as fp:
+            return PixelBeanDecoder.decode_stream(fp, executor, context)
+
+    @staticmethod
+    def decode_files(file_paths, workers: int = None) -> List[PixelBean]:
+        """Decode many files on a thread pool, returning beans in input order.
+
+        Each worker thread keeps one :class:`DecoderContext` for all the files it decodes.
+        Throughput scales with cores on free-threaded (no-GIL) Python; elsewhere the numpy,
+        AES and LZO work still overlaps.
+        """
+        from concurrent.futures import ThreadPoolExecutor
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            return list(pool.map(PixelBeanDecoder.decode_file, file_paths))
 
     @staticmethod
-    def decode_file(file_path: str) -> PixelBean:
+    def probe(file_path: str) -> Optional[FileHeader]:
+        """Read just the header: format, frame count and size (``None`` if unsupported)."""
+        import os
         with open(file_path, 'rb') as fp:
-            return PixelBeanDecoder.decode_stream(fp)
+            head = fp.read(16)
+        return _probe_header(head, os.path.getsize(file_path))
+
+    @staticmethod
+    def build_frame_index(fp: IOBase, checkpoint_every: int = 32,
+                          context: DecoderContext = None) -> FrameSeekIndex:
+        """Scan a whole file once (no pixel decoding) into a :class:`FrameSeekIndex`.
+
+        ``context`` supplies the decode plans the 0x1A frame validation walks with.
+        """
+        return _build_frame_index(fp, checkpoint_every, context)
+
+    @staticmethod
+    def load_frame_index(file_path: str, persist: bool = True,
+                         context: DecoderContext = None) -> FrameSeekIndex:
+        """Return the ``<file>.idx.json`` sidecar index, building (and saving) it if needed."""
+        import os
+        sidecar = FrameSeekIndex.sidecar_path(file_path)
+        if os.path.exists(sidecar):
+            try:
+                index = FrameSeekIndex.load(sidecar)
+                if index.file_size == os.path.getsize(file_path):
+                    return index
+            except (ValueError, KeyError):
+                logger.warning('Ignoring unreadable frame index %s', sidecar)
+        with open(file_path, 'rb') as fp:
+            index = _build_frame_index(fp, context=context)
+        if persist:
+            index.save(sidecar)
+        return index
+
+    @staticmethod
+    def decode_frame(fp: IOBase, k: int, index: FrameSeekIndex = None,
+                     context: DecoderContext = None) -> np.ndarray:
+        """Decode only frame ``k`` (0-based) as an ``(H, W, 3)`` array.
+
+        With an index, format-26 files read and decode just that frame (plus at most
+        ``checkpoint_every`` palette sections); other formats decode the whole file.
+        ``fp`` must be seekable. Without an index one is built first. ``context`` is used
+        as in :meth:`decode_stream`, for building the index too.
+        """
+        if index is None:
+            fp.seek(0)
+            index = _build_frame_index(fp, context=context)
+        return _decode_indexed_frame(fp, k, index, context)
 
     @staticmethod
-    def decode_stream(fp: IOBase) -> PixelBean:
+    def decode_stream(fp: IOBase, executor=None, context: DecoderContext = None) -> PixelBean:
         head = fp.read(1)
         if not head:
             logger.error('Empty stream')
@@ -1404,4 +1847,4 @@ class PixelBeanDecoder:
         except ValueError:
             logger.error('Unsupported file format: %d', head[0])
             return None
-        return _DECODERS[fmt](fp)
+        return _DECODERS[fmt](fp, executor, context)
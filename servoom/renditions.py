@@ -0,0 +1,100 @@
+"""Multi-output fan-out: decode an artwork once, encode many renditions from it.
+
+An output spec is ``<kind>[@<size>]``:
+
+* ``kind`` is ``webp`` or ``gif`` (the full animation) or ``thumb`` (a PNG of the
+  first frame).
+* ``size`` is a scale (``4x``, ``0.5x``) or a target width in pixels (``64``/``64px``),
+  keeping the aspect ratio. The default is ``1x`` (``64`` for ``thumb``).
+
+:func:`render_outputs` renders each distinct geometry once, so ``webp@4x`` and ``gif@4x``
+share the same scaled frames. It derives every scaled geometry from the shared 1x frames
+and runs the encoders concurrently. Pillow releases the GIL while encoding, so threads
+overlap.
+"""
+
+from __future__ import annotations
+
+import io
+import re
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, List, NamedTuple, Optional, Sequence
+
+from PIL import Image
+
+from .pixel_bean import PixelBean, write_gif, write_webp
+
+_SPEC = re.compile(r'^(webp|gif|thumb)(?:@(\d+(?:\.\d+)?)(x|px)?)?$')
+_EXTENSIONS = {'webp': 'webp', 'gif': 'gif', 'thumb': 'png'}
+
+
+class OutputSpec(NamedTuple):
+    kind: str
+    scale: Optional[float] = 1  # set when sized by factor
+    width: Optional[int] = None  # set when sized by target width
+
+    @classmethod
+    def parse(cls, text: str) -> 'OutputSpec':
+        match = _SPEC.match(text.strip().lower())
+        if match:
+            kind, size, unit = match.groups()
+            if size is None:
+                return cls(kind, None, 64) if kind == 'thumb' else cls(kind)
+            if unit == 'x' and float(size) > 0:
+                return cls(kind, float(size))
+            if unit != 'x' and int(float(size)) > 0:
+                return cls(kind, None, int(float(size)))
+        raise ValueError(f'Bad output spec {text!r} (expected e.g. webp@4x, gif, thumb@64)')
+
+    @property
+    def tag(self) -> str:
+        """``''`` for 1x, else ``'@4x'`` / ``'@64px'``."""
+        if self.width is not None:
+            return f'@{self.width}px'
+        return '' if self.scale == 1 else f'@{self.scale:g}x'
+
+    def filename(self, stem: str) -> str:
+        suffix = '.thumb' if self.kind == 'thumb' else ''
+        return f'{stem}{suffix}{self.tag}.{_EXTENSIONS[self.kind]}'
+
+    def scale_for(self, width: int) -> float:
+        """Linear scale this spec applies to an animation ``width`` pixels wide."""
+        return self.width / width if self.width is not None else self.scale
+
+
+def render_outputs(bean: PixelBean, specs: Sequence[OutputSpec],
+                   max_workers: Optional[int] = None) -> Dict[OutputSpec, bytes]:
+    """Encode ``bean`` once per spec (duplicates collapse); returns ``{spec: file bytes}``."""
+    specs = list(dict.fromkeys(specs))
+    base = [bean.get_frame_image(n + 1) for n in range(bean.total_frames)]
+
+    def resize(img: Image.Image, spec: OutputSpec) -> Image.Image:
+        # The same scaling get_frame_image(scale=, target_width=) applies
+        return bean._resize(img, scale=spec.scale or 1, target_width=spec.width)
+
+    geometries: Dict[tuple, List[Image.Image]] = {}
+    for spec in specs:
+        key = (spec.scale, spec.width)
+        if key in geometries:
+            continue
+        if spec.kind == 'thumb' and not any(s.kind != 'thumb' and (s.scale, s.width) == key
+                                            for s in specs):
+            geometries[key] = [resize(base[0], spec)]  # only the first frame is needed
+        else:
+            geometries[key] = [resize(img, spec) for img in base]
+
+    def encode(spec: OutputSpec) -> bytes:
+        frames = geometries[(spec.scale, spec.width)]
+        buf = io.BytesIO()
+        if spec.kind == 'thumb':
+            frames[0].save(buf, format='PNG')
+        elif spec.kind == 'gif':
+            write_gif(frames, buf, bean.speed)
+        else:
+            write_webp(frames, buf, bean.speed)
+        return buf.getvalue()
+
+    if len(specs) == 1:
+        return {specs[0]: encode(specs[0])}
+    with ThreadPoolExecutor(max_workers=max_workers or len(specs)) as pool:
+        return dict(zip(specs, pool.map(encode, specs)))
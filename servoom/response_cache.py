@@ -0,0 +1,147 @@
+"""Persistent API response cache and in-process request coalescing for ``DivoomSession``.
+
+:class:`ResponseCache` keeps successful (``ReturnCode`` 0) JSON responses in one SQLite
+file with a TTL per endpoint. Only endpoints with a TTL are cached. The defaults cover the
+lookups crawlers repeat (``GetSomeoneInfoV2``, ``Tag/GetTagInfo``, ``Cloud/GalleryInfo``).
+Listings and login are never cached unless you configure a TTL for them.
+
+:class:`Singleflight` makes concurrent identical requests share one network call: the
+first caller performs it, and the rest wait and get their own copy of its result.
+
+Cache keys (:func:`cache_key`) never contain credentials. ``Token``, ``Password`` and
+``Email`` are dropped, and ``UserId`` is replaced by a salted hash. Responses are still
+scoped per account (``IsLike``/``IsFollow`` and private uploads differ by viewer), a
+rotated token still hits, and the cache file holds no secrets.
+"""
+
+from __future__ import annotations
+
+import copy
+import hashlib
+import json
+import sqlite3
+import threading
+import time
+from pathlib import Path
+from typing import Callable, Dict, Optional, Union
+
+from .const import ApiEndpoint
+from .logging import get_logger
+
+log = get_logger(__name__)
+
+DEFAULT_TTLS: Dict[str, float] = {
+    ApiEndpoint.GET_SOMEONE_INFO.value: 3600,
+    ApiEndpoint.GET_TAG_INFO.value: 3600,
+    ApiEndpoint.GET_GALLERY_INFO.value: 600,
+}
+_SECRET_FIELDS = frozenset({'Token', 'Password', 'Email'})
+_SCOPED_FIELDS = frozenset({'UserId'})
+_KEY_SALT = b'servoom-response-cache-v1'
+
+
+def cache_key(path: str, payload: Optional[Dict]) -> str:
+    """Stable key for a request: endpoint + canonical payload, minus credentials."""
+    fields = {}
+    for name, value in (payload or {}).items():
+        if name in _SECRET_FIELDS:
+            continue
+        if name in _SCOPED_FIELDS:
+            value = hashlib.sha256(_KEY_SALT + str(value).encode()).hexdigest()[:16]
+        fields[name] = value
+    canonical = json.dumps(fields, sort_keys=True, separators=(',', ':'), default=str)
+    return hashlib.sha256(f'{path}\n{canonical}'.encode()).hexdigest()
+
+
+class Singleflight:
+    """Coalesce concurrent calls with the same key into one execution."""
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._calls: Dict[str, dict] = {}
+        self.coalesced = 0
+
+    def do(self, key: str, fn: Callable[[], Dict]) -> Dict:
+        with self._lock:
+            call = self._calls.get(key)
+            leader = call is None
+            if leader:
+                call = self._calls[key] = {'done': threading.Event()}
+            else:
+                self.coalesced += 1
+        if not leader:
+            call['done'].wait()
+            if 'error' in call:
+                raise call['error']
+            return copy.deepcopy(call['result'])
+        try:
+            call['result'] = fn()
+            return copy.deepcopy(call['result'])
+        except BaseException as exc:
+            call['error'] = exc
+            raise
+        finally:
+            with self._lock:
+                del self._calls[key]
+            call['done'].set()
+
+
+class ResponseCache:
+    """SQLite ``key -> response`` store with per-endpoint TTLs (seconds) and hit metrics."""
+
+    def __init__(self, path: Union[str, Path], ttls: Optional[Dict[str, float]] = None):
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self.ttls = dict(DEFAULT_TTLS if ttls is None else ttls)
+        self.hits = 0
+        self.misses = 0
+        self.expired = 0
+        self.stores = 0
+        self._lock = threading.Lock()
+        self._db = sqlite3.connect(str(self.path), check_same_thread=False)
+        with self._lock, self._db:
+            self._db.execute('PRAGMA journal_mode=WAL')
+            self._db.execute('CREATE TABLE IF NOT EXISTS response ('
+                             'key TEXT PRIMARY KEY, path TEXT, stored REAL, body TEXT)')
+
+    def ttl_for(self, path: str) -> float:
+        return self.ttls.get(path, 0)
+
+    def get(self, key: str, path: str) -> Optional[Dict]:
+        ttl = self.ttl_for(path)
+        with self._lock:
+            row = self._db.execute('SELECT stored, body FROM response WHERE key = ?',
+                                   (key,)).fetchone()
+            if row is not None and time.time() - row[0] <= ttl:
+                self.hits += 1
+                return json.loads(row[1])
+            if row is not None:
+                self.expired += 1
+            self.misses += 1
+        return None
+
+    def put(self, key: str, path: str, response: Dict) -> None:
+        if response.get('ReturnCode', 0) != 0:
+            return  # errors and throttling are never cached
+        with self._lock, self._db:
+            self._db.execute('INSERT OR REPLACE INTO response VALUES (?, ?, ?, ?)',
+                             (key, path, time.time(), json.dumps(response)))
+            self.stores += 1
+
+    def purge_expired(self) -> int:
+        """Delete entries past their endpoint's TTL; returns how many."""
+        now = time.time()
+        with self._lock, self._db:
+            rows = self._db.execute('SELECT key, path, stored FROM response').fetchall()
+            stale = [(k,) for k, p, stored in rows if now - stored > self.ttl_for(p)]
+            self._db.executemany('DELETE FROM response WHERE key = ?', stale)
+        return len(stale)
+
+    def metrics(self) -> Dict[str, int]:
+        with self._lock:
+            return {'hits': self.hits, 'misses': self.misses, 'expired': self.expired,
+                    'stores': self.stores}
+
+    def close(self) -> None:
+        with self._lock:
+            self._db.close()
@@ -0,0 +1,57 @@
+"""Round-trip tests for the compact ``.svan`` animation container."""
+
+from __future__ import annotations
+
+import io
+
+import numpy as np
+import pytest
+
+from servoom.animation_container import ContainerReader, read_container, write_container
+from servoom.pixel_bean import PixelBean
+
+
+def _bean(frames) -> PixelBean:
+    h, w = frames[0].shape[:2]
+    return PixelBean(metadata={}, total_frames=len(frames), speed=120,
+                     row_count=h // 16, column_count=w // 16, frames_data=frames)
+
+
+def _animation(colours: int, count: int = 40, size: int = 32) -> list:
+    rng = np.random.default_rng(colours)
+    if colours > size * size:  # more colours than pixels: per-frame noise
+        return list(rng.integers(0, 256, (count, size, size, 3), dtype=np.uint8))
+    palette = rng.integers(0, 256, (colours, 3), dtype=np.uint8)
+    base = rng.integers(0, colours, (size, size))
+    frames = []
+    for k in range(count):
+        idx = base.copy()
+        if k % 5:  # a moving sprite; every fifth frame repeats the previous one exactly
+            idx[k % size:k % size + 4, 3:9] = (k * 7) % colours
+        frames.append(palette[idx] if k % 5 or not frames else frames[-1].copy())
+    return frames
+
+
+@pytest.mark.parametrize("colours", [12, 3000, 1 << 24])  # uint8, uint16 and RGB groups
+def test_container_round_trips_frames_exactly(colours: int):
+    frames = _animation(colours, size=96 if colours > 65536 else 32)
+    buf = io.BytesIO()
+    write_container(_bean(frames), buf, group_size=16)
+
+    bean = read_container(buf.getvalue())
+    assert (bean.total_frames, bean.speed) == (40, 120)
+    for got, want in zip(bean.frames_data, frames):
+        assert np.array_equal(got, want)
+
+
+def test_container_random_access_decodes_one_group():
+    frames = _animation(40, count=100)
+    buf = io.BytesIO()
+    size = write_container(_bean(frames), buf, group_size=32)
+    assert size < sum(f.nbytes for f in frames) // 10
+
+    reader = ContainerReader(buf.getvalue())
+    for k in (99, 0, 33, 64):
+        assert np.array_equal(reader.frame(k), frames[k])
+    with pytest.raises(IndexError):
+        reader.frame(100)
@@ -0,0 +1,66 @@
+"""Tests for the frame-level content-addressed store."""
+
+from __future__ import annotations
+
+import hashlib
+import io
+import json
+from contextlib import redirect_stdout
+from pathlib import Path
+
+import numpy as np
+
+from servoom.frame_store import FrameStore
+from servoom.pixel_bean import PixelBean
+from servoom.pixel_bean_decoder import PixelBeanDecoder
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+BASELINE = json.loads((Path(__file__).parent / "reference_baseline.json").read_text("utf-8"))
+
+
+def _frame(seed: int) -> np.ndarray:
+    return np.random.default_rng(seed).integers(0, 8, (16, 16, 3), dtype=np.uint8) * 32
+
+
+def _bean(seeds, speed=100, **metadata) -> PixelBean:
+    return PixelBean(metadata=metadata, total_frames=len(seeds), speed=speed, row_count=1,
+                     column_count=1, frames_data=[_frame(s) for s in seeds])
+
+
+def test_shared_frames_are_stored_once_and_queries_find_remixes(tmp_path: Path):
+    root = tmp_path / "frames"
+    with FrameStore(root) as store:
+        store.add(1, _bean([0, 0, 0, 1, 2]))
+        store.add(2, _bean([0, 1, 3], OriginalGalleryId=1))
+        store.add(3, _bean([1, 3, 4]))  # shares frames but never declared a source
+        store.add(4, _bean([5]))
+        record = store.record(1)
+        assert len(record.frames) == 3 and record.durations == (300, 100, 100)
+        assert store.stats()["unique_frames"] == 6
+
+        assert store.sharing(1) == [("2", 2), ("3", 1)]
+        assert store.sharing(2, min_shared=2) == [("1", 2), ("3", 2)]
+        assert store.remixes(1) == ["2"] and store.sharing(4) == []
+
+    with FrameStore(root) as store:  # the manifest and index survive a reopen
+        bean = store.to_pixel_bean(1)
+        assert bean.total_frames == 5 and bean.speed == 100
+        for got, seed in zip(bean.frames_data, [0, 0, 0, 1, 2]):
+            assert np.array_equal(got, _frame(seed))
+        assert store.to_pixel_bean(2).metadata["OriginalGalleryId"] == 1
+
+        store.delete(4)
+        assert store.compact() > 0
+        assert store.stats()["unique_frames"] == 5 and 4 not in store
+
+
+def test_reference_animation_round_trips_exactly(tmp_path: Path):
+    rel = next(iter(BASELINE))
+    with redirect_stdout(io.StringIO()):
+        bean = PixelBeanDecoder.decode_file(str(REPO_ROOT / rel))
+    with FrameStore(tmp_path / "frames") as store:
+        store.add("ref", bean)
+        stats = store.stats()
+        assert stats["stored_bytes"] < stats["raw_bytes"]
+        frames = b"".join(f.tobytes() for f in store.frames("ref"))
+    assert hashlib.sha256(frames).hexdigest() == BASELINE[rel]["hash"]
@@ -0,0 +1,117 @@
+"""Tests for the local mock Divoom API server and the client benchmark runner."""
+
+from __future__ import annotations
+
+import io
+import time
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import redirect_stdout
+from dataclasses import replace
+from pathlib import Path
+
+from servoom.client import DivoomClient, FetchFailed
+from servoom.metadata_cache import MetadataCache
+from servoom.mock_server import MockConfig, MockDivoomServer, run_benchmark
+from servoom.packstore import PackStore
+from servoom.response_cache import cache_key
+
+
+def _client(server: MockDivoomServer, **overrides) -> DivoomClient:
+    client = DivoomClient(email="mock@localhost", md5_password="0" * 32,
+                          settings=server.settings(**overrides))
+    assert client.login()
+    return client
+
+
+def test_client_crawls_downloads_and_decodes_from_the_mock(tmp_path: Path):
+    config = MockConfig(items=120, hidden_rate=0.1, frames=3, grid=2)
+    with MockDivoomServer(config) as server:
+        client = _client(server, batch_size=25)
+        visible = [r for r in server.catalogue.records if not r["HideFlag"]]
+        beans = client.fetch_someone_arts_as_beans(42)
+        assert [b.gallery_id for b in beans] == [r["GalleryId"] for r in visible]
+        assert client.fetch_artwork_info(visible[3]["GalleryId"])["FileId"] == visible[3]["FileId"]
+
+        with PackStore(tmp_path / "store") as store:
+            assert len(client._download_beans(beans[:5], str(tmp_path), store)) == 5
+            with redirect_stdout(io.StringIO()):
+                bean = client.decode_art(beans[0], store=store)
+        assert bean.total_frames == 3 and (bean.width, bean.height) == (32, 32)
+        assert server.stats.files == 5
+
+
+def test_throttling_return_codes_cut_a_crawl_short_and_say_so(caplog):
+    with MockDivoomServer(MockConfig(items=200, hidden_rate=0, throttle_rate=0.5)) as server:
+        items = _client(server, batch_size=10).fetch_someone_arts(1)
+        assert len(items) < 200 and server.stats.throttled >= 1
+    assert f"at StartNum={len(items) + 1}: ReturnCode=10; the listing is incomplete" in caplog.text
+
+
+def test_benchmark_reports_crawl_and_download_rates():
+    with MockDivoomServer(MockConfig(items=60, hidden_rate=0)) as server:
+        result = run_benchmark(server.settings(batch_size=20), downloads=10)
+    assert result["crawl_items"] == 60 and result["downloads"] == 10
+    assert result["items_per_s"] > 0 and result["mb_per_s"] > 0
+    assert result["download_bytes"] == 10 * len(server.catalogue.payload(
+        server.catalogue.records[0]["FileId"]))
+
+
+def test_bulk_metadata_fetch_dedupes_caches_and_rate_limits(tmp_path: Path):
+    with MockDivoomServer(MockConfig(items=100, latency=0.01)) as server:
+        client = _client(server, fetch_workers=4, requests_per_second=20)
+        ids = [1_000_000 + i for i in range(40)] * 2 + [5]  # duplicates + an unknown id
+        with MetadataCache(tmp_path / "meta.sqlite") as cache:
+            started = time.perf_counter()
+            results = dict(client.fetch_artwork_infos(ids, cache=cache))
+            elapsed = time.perf_counter() - started
+            assert len(results) == 41 and results[5] is None
+            assert results[1_000_007]["FileId"] == server.catalogue.records[7]["FileId"]
+            assert elapsed >= 0.9  # 41 calls at 20/s behind the shared limiter, burst of 20
+            assert len(cache) == 40
+
+            before = server.stats.requests
+            again = dict(client.fetch_artwork_infos(ids[:40], cache=cache))
+            assert again == {k: v for k, v in results.items() if k != 5}
+            assert server.stats.requests == before  # all hits
+            refreshed = dict(client.fetch_artwork_infos(ids[:3], cache=cache, max_age=0))
+            assert len(refreshed) == 3 and server.stats.requests == before + 3
+
+
+def test_bulk_metadata_fetch_retries_throttles_and_flags_failures():
+    config = MockConfig(items=20, throttle_rate=0.3, throttle_code=42)
+    with MockDivoomServer(config) as server:
+        ids = [1_000_000 + i for i in range(10)] + [5]  # ... and an unknown id
+        results = dict(_client(server, max_retries=10).fetch_artwork_infos(ids))
+        assert server.stats.throttled > 0
+        assert all(results[i]["GalleryId"] == i for i in ids[:10]) and results[5] is None
+
+
+    with MockDivoomServer(replace(config, throttle_rate=1.0)) as server:
+        failed = dict(_client(server, max_retries=1).fetch_artwork_infos(ids[:3]))
+    assert all(isinstance(v, FetchFailed) and not v for v in failed.values())
+
+
+def test_response_cache_persists_coalesces_and_keeps_credentials_out(tmp_path: Path):
+    path = str(tmp_path / "responses.sqlite")
+    with MockDivoomServer(MockConfig(items=10, latency=0.2)) as server:
+        client = _client(server, response_cache_path=path)
+        with ThreadPoolExecutor(8) as pool:  # identical concurrent lookups: one request
+            infos = list(pool.map(lambda _: client.fetch_someone_info(123), range(8)))
+        assert all(info == infos[0] for info in infos) and infos[0]["UserId"] == 123
+        assert server.stats.by_path["/GetSomeoneInfoV2"] == 1
+        assert client._session.metrics()["coalesced"] == 7
+
+        second = _client(server, response_cache_path=path)  # new process, new token
+        second.token = "rotated-token"
+        assert second.fetch_someone_info(123) == infos[0]
+        assert second._session.metrics()["hits"] == 1
+        assert server.stats.by_path["/GetSomeoneInfoV2"] == 1
+        second.fetch_someone_arts(1, limit=5)  # listings have no TTL: not cached
+        second.fetch_someone_arts(1, limit=5)
+        assert server.stats.by_path["/GetSomeoneListV2"] == 2
+
+    raw = (tmp_path / "responses.sqlite").read_bytes()
+    assert b"mock-token" not in raw and b"rotated-token" not in raw
+    assert cache_key("/X", {"Token": "a", "UserId": 1}) == \
+        cache_key("/X", {"Token": "b", "UserId": 1})
+    assert cache_key("/X", {"UserId": 1}) != cache_key("/X", {"UserId": 2})
@@ -0,0 +1,165 @@
+"""Tests for the append-only packfile store of raw ``.dat`` blobs."""
+
+from __future__ import annotations
+
+import hashlib
+import io
+import json
+import struct
+import tracemalloc
+from contextlib import redirect_stdout
+from pathlib import Path
+
+from Crypto.Cipher import AES
+
+from servoom.client import DivoomClient
+from servoom.csv_export import export_artworks_to_csv
+from servoom.packstore import _PLAINTEXT, PackStore, benchmark_dictionaries
+from servoom.pixel_bean import PixelBean
+from servoom.pixel_bean_decoder import BaseDecoder
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+REFERENCE = REPO_ROOT / "reference-animations"
+BASELINE = json.loads((Path(__file__).parent / "reference_baseline.json").read_text("utf-8"))
+
+
+def test_imported_blobs_decode_from_mapped_segments(tmp_path: Path):
+    with PackStore(tmp_path / "store", max_segment_bytes=64 << 10) as store:
+        assert store.import_tree(REFERENCE) == len(BASELINE)
+        assert len(list((tmp_path / "store").glob("seg-*.pack"))) > 1
+        for key in store.keys():
+            assert isinstance(store.get(key), memoryview)
+            with redirect_stdout(io.StringIO()):
+                bean = store.decode(key)
+            frames = b"".join(f.tobytes() for f in bean.frames_data)
+            expected = BASELINE[f"reference-animations/{key}"]
+            assert hashlib.sha256(frames).hexdigest() == expected["hash"]
+
+
+def test_overwrite_delete_compact_and_reopen(tmp_path: Path):
+    root = tmp_path / "store"
+    with PackStore(root) as store:
+        store.put("a", b"first")
+        store.put("b", b"x" * 1000)
+        store.put("a", b"second")
+        store.delete("b")
+        assert bytes(store.get("a")) == b"second" and "b" not in store
+        freed = store.compact()
+        assert freed >= 1000
+        assert store.verify() == []
+
+    with PackStore(root) as store:  # the index survives a reopen
+        assert list(store.keys()) == ["a"]
+        assert bytes(store.get("a", verify=True)) == b"second"
+        (root / "index.jsonl").unlink()
+    with PackStore(root) as store:
+        assert store.rebuild_index() == 1
+        assert bytes(store.get("a")) == b"second"
+
+
+def test_imported_downloads_are_found_by_decode_art(tmp_path: Path):
+    src = tmp_path / "downloads"
+    src.mkdir()
+    sample = next(REFERENCE.rglob("*.dat"))
+    (src / "4164515_sample.dat").write_bytes(sample.read_bytes())
+    metadata = {"GalleryId": 4164515, "FileId": "group1/M00/sample", "FileName": "sample"}
+    export_artworks_to_csv([PixelBean(metadata=metadata)], output_dir=str(src),
+                           include_tags=False)
+    client = DivoomClient(email="mock@localhost", md5_password="0" * 32)
+    with PackStore(tmp_path / "store") as store:
+        assert store.import_tree(src) == 1
+        assert list(store.keys()) == ["group1/M00/sample"]
+        bean = PixelBean(metadata=metadata)
+        bean.update_from_download(store.uri(bean.file_id))
+        with redirect_stdout(io.StringIO()):
+            client.decode_art(bean, store=store)
+    assert bean.total_frames > 0
+
+
+def test_compact_streams_one_record_at_a_time(tmp_path: Path):
+    blob = 1 << 20
+    with PackStore(tmp_path / "store", max_segment_bytes=4 * blob) as store:
+        for i in range(16):
+            store.put(f"k{i}", bytes([i]) * blob)
+        store.put("k0", b"gone")  # leave something to reclaim
+        tracemalloc.start()
+        try:
+            assert store.compact() >= blob
+            _, peak = tracemalloc.get_traced_memory()
+        finally:
+            tracemalloc.stop()
+        assert peak < 2 * blob
+        assert bytes(store.get("k5", verify=True)) == bytes([5]) * blob
+        assert store.verify() == []
+
+
+def test_export_round_trips_and_verify_flags_corruption(tmp_path: Path):
+    src = tmp_path / "downloads"
+    (src / "123").mkdir(parents=True)
+    (src / "123" / "456_art.dat").write_bytes(b"\x1a" + bytes(range(200)))
+    root = tmp_path / "store"
+    with PackStore(root) as store:
+        store.import_tree(src)
+        assert store.export_tree(tmp_path / "out") == 1
+    assert (tmp_path / "out" / "123" / "456_art.dat").read_bytes() == b"\x1a" + bytes(range(200))
+
+    segment = next(root.glob("seg-*.pack"))
+    data = bytearray(segment.read_bytes())
+    data[-1] ^= 0xFF
+    segment.write_bytes(bytes(data))
+    with PackStore(root) as store:
+        assert store.verify() == ["123/456_art.dat"]
+
+
+def _encrypt(body: bytes) -> bytes:
+    cipher = AES.new(BaseDecoder.AES_SECRET_KEY.encode(), AES.MODE_CBC, BaseDecoder.AES_IV)
+    return cipher.encrypt(body)
+
+
+def _format_9(seed: int) -> bytes:
+    """A 16x16 format-9 file: 4-byte header + AES-CBC frames sharing most pixels."""
+    frames = b"".join(bytes((i * 3 + (i % 16 == seed % 16) * f) % 256 for i in range(768))
+                      for f in range(2))
+    return bytes([9, 0, 0, 100]) + _encrypt(frames)
+
+
+def _aes_body(seed: int) -> bytes:
+    return bytes((i * 5 + (i % 32 == seed % 32)) % 256 for i in range(2048))
+
+
+def test_format_17_and_18_archive_as_plaintext(tmp_path: Path):
+    # Header lengths come from PicMultiDecoder ('>BBI') and AnimMultiDecoder ('>BHBB').
+    blobs = {
+        "pic": bytes([17]) + struct.pack(">BBI", 2, 2, 2048) + _encrypt(_aes_body(1)),
+        "anim": bytes([18]) + struct.pack(">BHBB", 4, 100, 2, 2) + _encrypt(_aes_body(2)),
+    }
+    with PackStore(tmp_path / "store", archival=True) as store:
+        for key, blob in blobs.items():
+            store.put(key, blob)
+            assert store.entry(key).flags & _PLAINTEXT, key
+    with PackStore(tmp_path / "store") as store:
+        for key, blob in blobs.items():
+            assert bytes(store.get(key, verify=True)) == blob
+
+
+def test_archival_mode_compresses_with_dictionaries_and_reads_back_exactly(tmp_path: Path):
+    blobs = {f"k{i}": _format_9(i) for i in range(40)}
+    with PackStore(tmp_path / "store") as store:
+        for key, blob in blobs.items():
+            store.put(key, blob)
+        trained = store.train_dictionaries(dict_size=2048)
+        assert 9 in trained
+        entry = store.entry("k0")
+        assert entry.dict_id == trained[9] and entry.length < len(blobs["k0"]) // 4
+        store.put("late", _format_9(99))  # later puts use the dictionary too
+        assert store.entry("late").dict_id == trained[9]
+
+    with PackStore(tmp_path / "store") as store:  # reopened: archival from the saved dicts
+        assert store.archival and store.verify() == []
+        for key, blob in blobs.items():
+            assert bytes(store.get(key)) == blob
+        with redirect_stdout(io.StringIO()):
+            bean = store.decode("k3")
+        assert bean.total_frames == 2
+        stats = benchmark_dictionaries(store, decode=False)
+        assert stats["zstd+dict"]["ratio"] > stats["raw"]["ratio"] == 1.0
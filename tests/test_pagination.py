@@ -0,0 +1,145 @@
+"""Tests for sequential and range-partitioned (concurrent) pagination."""
+
+from __future__ import annotations
+
+import random
+import threading
+import time
+
+import pytest
+
+from servoom.http import BatchTuner, estimate_total, paginate
+
+
+class FakeListing:
+    """Thread-safe stand-in for ``post_json`` that answers out of order (random latency)."""
+
+    def __init__(self, total: int, fail_at: int = None, seed: int = 0):
+        self.items = [{"GalleryId": i, "HideFlag": int(i % 7 == 0)} for i in range(total)]
+        self.fail_at = fail_at
+        self.calls = []
+        self._rng = random.Random(seed)
+        self._lock = threading.Lock()
+
+    def __call__(self, path, payload):
+        with self._lock:
+            self.calls.append(payload["StartNum"])
+            delay = self._rng.uniform(0, 0.004)
+        time.sleep(delay)
+        start, end = payload["StartNum"], payload["EndNum"]
+        if self.fail_at is not None and start <= self.fail_at <= end:
+            return {"ReturnCode": 10}
+        return {"ReturnCode": 0, "FileList": self.items[start - 1:end]}
+
+
+def _run(post, **kwargs):
+    pages = []
+    items = list(paginate(post, "/List", {}, on_page=lambda s, n: pages.append((s, n)),
+                          **kwargs))
+    return [i["GalleryId"] for i in items], pages
+
+
+@pytest.mark.parametrize("kwargs", [
+    {"batch_size": 10},
+    {"batch_size": 7, "keep": lambda item: not item["HideFlag"]},
+    {"batch_size": 10, "limit": 33},
+    {"batch_size": 9, "limit": 40, "keep": lambda item: not item["HideFlag"]},
+])
+def test_concurrent_windows_yield_exactly_the_sequential_result(kwargs):
+    expected = _run(FakeListing(95), **kwargs)
+    for concurrency in (2, 4, 16):
+        assert _run(FakeListing(95, seed=concurrency), concurrency=concurrency,
+                    **kwargs) == expected
+
+
+def test_stops_at_first_empty_or_error_page_and_bounds_wasted_requests():
+    post = FakeListing(95)
+    ids, pages = _run(post, batch_size=10, concurrency=4)
+    assert ids == list(range(95)) and pages[-1] == (91, 95)
+    assert max(post.calls) <= 91 + 10 * 4  # at most concurrency - 1 windows past the end
+
+    ids, _ = _run(FakeListing(95, fail_at=45), batch_size=10, concurrency=4)
+    assert ids == list(range(40))  # pages after the throttled window are discarded
+
+
+def test_estimate_total_bounds_the_windows_requested():
+    for n in (0, 1, 2, 3, 64, 95, 1000):
+        assert estimate_total(FakeListing(n), "/List", {}) == n
+    post = FakeListing(95)
+    ids, _ = _run(post, batch_size=10, concurrency=8, total=95)
+    assert ids == list(range(95)) and max(post.calls) == 91
+
+
+class CappedListing(FakeListing):
+    """Caps pages at ``cap`` items and throttles the first ``throttles`` large requests."""
+
+    def __init__(self, total: int, cap: int, throttles: int = 0):
+        super().__init__(total)
+        self.cap, self.throttles = cap, throttles
+
+    def __call__(self, path, payload):
+        if self.throttles and payload["EndNum"] - payload["StartNum"] >= 10:
+            self.throttles -= 1
+            return {"ReturnCode": 10}
+        end = min(payload["EndNum"], payload["StartNum"] + self.cap - 1)
+        return super().__call__(path, {**payload, "EndNum": end})
+
+
+def test_tuner_grows_clamps_to_the_server_cap_and_remembers(tmp_path):
+    state = tmp_path / "batch_sizes.json"
+    tuner = BatchTuner(10, max_size=200, backoff_s=0, path=state)
+    ids = [i["GalleryId"] for i in paginate(CappedListing(500, cap=60), "/List", {},
+                                            batch_size=10, tuner=tuner)]
+    assert ids == list(range(500))  # capped pages are continued, not skipped
+    assert tuner.size_for("/List") == 60
+
+    post = CappedListing(500, cap=60)
+    reloaded = BatchTuner(10, path=state)
+    assert reloaded.size_for("/List") == 60
+    assert len(list(paginate(post, "/List", {}, batch_size=10, tuner=reloaded))) == 500
+    assert len(post.calls) == 500 // 60 + 2  # every window full from the start
+
+
+def test_tuner_backs_off_and_retries_throttled_windows():
+    tuner = BatchTuner(40, backoff_s=0)
+    post = CappedListing(100, cap=100, throttles=2)
+    ids = [i["GalleryId"] for i in paginate(post, "/List", {}, batch_size=40, tuner=tuner)]
+    assert ids == list(range(100)) and post.throttles == 0
+    assert post.calls[1] - post.calls[0] == 10  # 40 -> 20 -> 10 after two throttles
+
+
+def test_tuner_keeps_retrying_at_min_size_then_reports_giving_up(caplog):
+    post = CappedListing(100, cap=100, throttles=4)  # 40, then 20 three times
+    ids = [i["GalleryId"] for i in paginate(post, "/List", {}, batch_size=40,
+                                            tuner=BatchTuner(40, min_size=20, backoff_s=0))]
+    assert ids == list(range(100)) and post.throttles == 0
+    assert "incomplete" not in caplog.text
+
+    post = CappedListing(100, cap=100, throttles=10)
+    ids = [i["GalleryId"] for i in paginate(post, "/List", {}, batch_size=40,
+                                            tuner=BatchTuner(40, min_size=20, backoff_s=0))]
+    assert ids == [] and post.throttles == 5  # 40 once, then 20 up to max_throttles + 1
+    assert "Giving up on /List at StartNum=1 after 5 throttled requests" in caplog.text
+
+
+def test_tuner_stops_on_non_throttle_errors_without_learning_from_them(tmp_path):
+    state = tmp_path / "batch_sizes.json"
+    tuner = BatchTuner(40, backoff_s=60, path=state)  # a backoff would hang the test
+    calls = []
+
+    def post(path, payload):
+        calls.append(payload["StartNum"])
+        if payload["StartNum"] > 1:
+            return {"ReturnCode": 3}  # e.g. an expired token, not "slow down"
+        return {"ReturnCode": 0, "FileList": [{"GalleryId": i} for i in range(40)]}
+
+    ids = [i["GalleryId"] for i in paginate(post, "/List", {}, batch_size=40, tuner=tuner)]
+    assert ids == list(range(40)) and calls == [1, 41]
+    assert tuner.size_for("/List") == 60  # grown by the fast full page, never halved
+    assert not state.exists()
+
+    throttled = [i["GalleryId"] for i in paginate(CappedListing(50, cap=50, throttles=1),
+                                                  "/List", {}, batch_size=40,
+                                                  tuner=BatchTuner(40, backoff_s=0),
+                                                  throttle_codes=(99,))]
+    assert throttled == []  # 10 is only a throttle when configured as one
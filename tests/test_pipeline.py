@@ -0,0 +1,174 @@
+"""Tests for the staged batch executor, the memory-budget scheduler and the ``decode`` CLI."""
+
+from __future__ import annotations
+
+import io
+import tarfile
+import threading
+import zipfile
+from pathlib import Path
+
+import pytest
+from PIL import Image
+
+from servoom.cli import main
+from servoom.pipeline import Pipeline
+from servoom.pixel_bean_decoder import PixelBeanDecoder
+from servoom.renditions import OutputSpec
+from servoom.scheduler import MemoryBudget, estimate_peak_bytes, interleave_by_size
+from servoom.sinks import load_index, open_sink, read_entry
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+
+
+def test_pipeline_runs_every_item_and_isolates_failures():
+    in_flight, peak, lock = [0], [0], threading.Lock()
+
+    def slow_square(x):
+        with lock:
+            in_flight[0] += 1
+            peak[0] = max(peak[0], in_flight[0])
+        try:
+            if x == 3:
+                raise ValueError("boom")
+            return x * x
+        finally:
+            with lock:
+                in_flight[0] -= 1
+
+    pipeline = Pipeline([
+        ("double", lambda x: x * 2 if x != 5 else None, 2),  # None drops the item
+        ("square", lambda x: slow_square(x // 2), 3),
+    ], queue_size=1)
+    results = sorted(pipeline.run(range(10)))
+
+    assert results == [x * x for x in range(10) if x not in (3, 5)]
+    double, square = pipeline.stats
+    assert (double.items, double.failed) == (10, 0)
+    assert (square.items, square.failed) == (9, 1)
+    assert peak[0] <= 3
+    assert set(pipeline.utilization()) == {"double", "square"}
+    assert pipeline.bottleneck() in ("double", "square")
+
+
+def test_pipeline_forwards_input_errors_to_the_consumer():
+    def items():
+        yield from range(3)
+        raise OSError("listing failed")
+
+    pipeline = Pipeline([("inc", lambda x: x + 1, 2)], queue_size=1)
+    seen = []
+    with pytest.raises(OSError, match="listing failed"):
+        for result in pipeline.run(items()):
+            seen.append(result)
+    assert sorted(seen) == [1, 2, 3]
+
+
+def test_closing_the_results_early_stops_every_worker():
+    pipeline = Pipeline([("slow", lambda x: x, 2), ("noop", lambda x: x, 2)], queue_size=1)
+    results = pipeline.run(range(10_000))
+    assert next(results) is not None
+    results.close()
+    workers = [t for t in threading.enumerate()
+               if t.name.startswith(("slow-", "noop-", "pipeline-feed"))]
+    assert workers == []
+    assert pipeline.stats[0].items < 10_000
+
+
+def test_memory_budget_blocks_until_released_and_runs_oversize_jobs_alone():
+    budget = MemoryBudget(100)
+    assert budget.acquire(60) == 60
+    admitted = threading.Event()
+
+    def oversize():
+        budget.release(budget.acquire(500))  # charged the whole budget
+        admitted.set()
+
+    t = threading.Thread(target=oversize)
+    t.start()
+    assert not admitted.wait(0.2)
+    budget.release(60)
+    assert admitted.wait(5)
+    t.join()
+    assert (budget.in_use, budget.peak) == (0, 100)
+
+
+def test_scheduler_estimates_from_header_and_interleaves_sizes():
+    path = next((REPO_ROOT / "reference-animations").rglob("*.dat"))
+    header = PixelBeanDecoder.probe(str(path))
+    bean = PixelBeanDecoder.decode_file(str(path))
+    assert header.raw_bytes == bean.total_frames * bean.width * bean.height * 3
+    assert estimate_peak_bytes(header) == 3 * header.raw_bytes
+    assert estimate_peak_bytes(None) == 0
+    assert interleave_by_size([1, 5, 2, 4, 3], size=int) == [5, 1, 4, 2, 3]
+
+
+def test_decode_cli_pipeline_writes_every_file(tmp_path: Path):
+    src = REPO_ROOT / "reference-animations" / "mixed" / "DAT"
+    args = ["decode", str(src), "-o", str(tmp_path), "-j", "2", "-f", "gif", "--memory-budget", "4"]
+    assert main(args) == 0
+    written = sorted(p.stem for p in tmp_path.glob("*.gif"))
+    assert written == sorted(p.stem.split("_")[0] for p in src.glob("*.dat"))
+    assert all(p.read_bytes()[:6] == b"GIF89a" for p in tmp_path.glob("*.gif"))
+
+
+def test_decode_cli_fans_out_one_decode_to_many_renditions(tmp_path: Path):
+    src = next((REPO_ROOT / "reference-animations").rglob("*.dat"))
+    stem = src.stem.split("_")[0]
+    args = ["decode", str(src), "-o", str(tmp_path),
+            "--output", "webp", "--output", "webp@2x", "--output", "gif@0.5x",
+            "--output", "thumb@64"]
+    assert main(args) == 0
+
+    bean = PixelBeanDecoder.decode_file(str(src))
+    reference = io.BytesIO()
+    bean.save_to_webp(reference)
+    assert (tmp_path / f"{stem}.webp").read_bytes() == reference.getvalue()
+    expected = {f"{stem}@2x.webp": (bean.width * 2, bean.total_frames),
+                f"{stem}@0.5x.gif": (bean.width // 2, bean.total_frames),
+                f"{stem}.thumb@64px.png": (64, 1)}
+    for name, (width, frames) in expected.items():
+        with Image.open(tmp_path / name) as im:
+            assert (im.width, getattr(im, "n_frames", 1)) == (width, frames)
+
+
+def test_output_spec_parsing():
+    assert OutputSpec.parse("webp@4x") == OutputSpec("webp", 4.0)
+    assert OutputSpec.parse("GIF") == OutputSpec("gif")
+    assert OutputSpec.parse("thumb") == OutputSpec("thumb", None, 64)
+    assert OutputSpec.parse("webp@64px").scale_for(128) == 0.5
+    for bad in ("png@2x", "webp@0x", "thumb@0", "gif@0.4px"):
+        with pytest.raises(ValueError, match="Bad output spec"):
+            OutputSpec.parse(bad)
+
+
+@pytest.mark.parametrize("kind", ["tar", "zip"])
+def test_archive_sink_rolls_over_and_indexes_entries(tmp_path: Path, kind: str):
+    blobs = {str(4130000 + i): bytes([i]) * (700 + i) for i in range(6)}
+    with open_sink(kind, tmp_path, max_bytes=2048) as sink:
+        for key, data in blobs.items():
+            sink.write(key, f"{key}.webp", data)
+
+    index = load_index(tmp_path / "export.index.jsonl")
+    archives = {rec["archive"] for recs in index.values() for rec in recs}
+    assert len(archives) > 1
+    for key, data in blobs.items():
+        (record,) = index[int(key)]
+        assert read_entry(record, tmp_path) == data
+    opener = tarfile.open if kind == "tar" else zipfile.ZipFile
+    for name in archives:  # the archives stay valid for ordinary tools too
+        with opener(tmp_path / name) as archive:
+            assert archive.getnames() if kind == "tar" else archive.namelist()
+
+
+@pytest.mark.parametrize("kind", ["tar", "zip"])
+def test_archive_sink_index_lines_are_readable_before_close(tmp_path: Path, kind: str):
+    sink = open_sink(kind, tmp_path, fsync=True)
+    try:
+        for i in range(3):  # a crash now leaves no tar trailer / zip directory
+            sink.write(str(i), f"{i}.webp", bytes([i]) * 300)
+        index = load_index(tmp_path / "export.index.jsonl")
+        assert [read_entry(index[i][0], tmp_path) for i in range(3)] == \
+            [bytes([i]) * 300 for i in range(3)]
+    finally:
+        sink.close()
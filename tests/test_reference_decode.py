@@ -14,11 +14,18 @@ from __future__ import annotations
 import hashlib
 import io
 import json
+import os
+import subprocess
+import sys
+from concurrent.futures import ProcessPoolExecutor
 from contextlib import redirect_stdout
 from pathlib import Path
 
 import pytest
 
+from servoom.frame_cache import FrameCache
+from servoom.frame_transport import (FrameDescriptor, FrameSlabRing, attach_bean,
+                                     decode_files_shared, decode_into_slab)
 from servoom.layer_file_decoder import LayerFileDecoder
 from servoom.pixel_bean_decoder import PixelBeanDecoder
 
@@ -30,7 +37,7 @@ def _sha256(data: bytes) -> str:
     return hashlib.sha256(data).hexdigest()
 
 
-def _decode(path: Path) -> dict:
+def _decode(path: Path, executor=None) -> dict:
     """Decode a reference asset into the same summary shape as the baseline fixture."""
     with redirect_stdout(io.StringIO()):  # decoders are chatty; keep test output clean
         is_layer = path.read_bytes()[:1] == b"\x27"
@@ -41,7 +48,7 @@ def _decode(path: Path) -> dict:
             )
             return {"kind": "layer", "frames": layer.num_frames,
                     "width": layer.width, "height": layer.height, "hash": _sha256(frames)}
-        bean = PixelBeanDecoder.decode_file(str(path))
+        bean = PixelBeanDecoder.decode_file(str(path), executor=executor)
         frames = b"".join(
             bean.frames_data[i].tobytes() for i in range(bean.total_frames)
         )
@@ -63,3 +70,130 @@ def test_baseline_covers_every_reference_dat() -> None:
         for p in (REPO_ROOT / "reference-animations").rglob("*.dat")
     }
     assert on_disk == set(BASELINE)
+
+
+def test_frame_parallel_decode_matches_baseline() -> None:
+    """Frames decoded across a process pool must hash identically to the sequential decode."""
+    rel_path = next(p for p in sorted(BASELINE) if BASELINE[p]["kind"] == "pixel")
+    with ProcessPoolExecutor(max_workers=2) as executor:
+        got = _decode(REPO_ROOT / rel_path, executor)
+    assert got == BASELINE[rel_path]
+
+
+def test_threaded_batch_decode_matches_baseline() -> None:
+    """Decoding many files at once on a thread pool must not disturb any of them."""
+    rel_paths = [p for p in sorted(BASELINE) if BASELINE[p]["kind"] == "pixel"]
+    with redirect_stdout(io.StringIO()):
+        beans = PixelBeanDecoder.decode_files([str(REPO_ROOT / p) for p in rel_paths], workers=4)
+    for rel_path, bean in zip(rel_paths, beans):
+        frames = b"".join(bean.frames_data[i].tobytes() for i in range(bean.total_frames))
+        assert _sha256(frames) == BASELINE[rel_path]["hash"]
+
+
+def test_shared_memory_handoff_matches_baseline() -> None:
+    """Frames handed back through shared-memory slabs hash like a direct decode; beans too
+    big for a slab come back by value."""
+    rel_paths = [p for p in sorted(BASELINE) if BASELINE[p]["kind"] == "pixel"]
+    smallest = min(BASELINE[p]["frames"] * BASELINE[p]["width"] * BASELINE[p]["height"] * 3
+                   for p in rel_paths)
+    kinds = set()
+    with FrameSlabRing(slots=2, slot_bytes=smallest) as ring, \
+            ProcessPoolExecutor(max_workers=2) as executor:
+        for path, item in decode_files_shared([REPO_ROOT / p for p in rel_paths], executor, ring):
+            kinds.add(type(item))
+            if isinstance(item, FrameDescriptor):
+                with attach_bean(item) as bean:  # as an encoder process would
+                    frames = b"".join(f.tobytes() for f in bean.frames_data)
+                    del bean
+            else:
+                frames = b"".join(f.tobytes() for f in ring.view(item).frames_data)
+            ring.release(item)
+            assert _sha256(frames) == BASELINE[path.relative_to(REPO_ROOT).as_posix()]["hash"]
+    assert len(kinds) == 2
+
+
+_ATTACH_SCRIPT = """
+import hashlib, sys
+from servoom.frame_transport import FrameDescriptor, attach_bean
+desc = FrameDescriptor(sys.argv[1], *map(int, sys.argv[2:]))
+with attach_bean(desc) as bean:
+    print(hashlib.sha256(b"".join(f.tobytes() for f in bean.frames_data)).hexdigest())
+    del bean
+"""
+
+
+def test_unrelated_process_can_attach_without_unlinking_the_slab() -> None:
+    """A process outside the pool has its own resource tracker; attaching must not hand it
+    the segment, or its exit would unlink the ring's memory."""
+    rel_path = next(p for p in sorted(BASELINE) if BASELINE[p]["kind"] == "pixel")
+    expected = BASELINE[rel_path]["hash"]
+    with FrameSlabRing(slots=1, slot_bytes=64 << 20) as ring:
+        with redirect_stdout(io.StringIO()):
+            desc = decode_into_slab(str(REPO_ROOT / rel_path), ring.name, 0, ring.slot_bytes)
+        assert isinstance(desc, FrameDescriptor)
+        env = dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path))
+        for _ in range(2):  # the second attach fails if the first child unlinked the slab
+            child = subprocess.run([sys.executable, "-c", _ATTACH_SCRIPT, desc.shm_name,
+                                    *map(str, desc[1:])],
+                                   capture_output=True, text=True, env=env, timeout=60)
+            assert child.returncode == 0, child.stderr
+            assert child.stdout.strip().endswith(expected)
+            assert "leaked" not in child.stderr
+        frames = b"".join(f.tobytes() for f in ring.view(desc).frames_data)
+        assert _sha256(frames) == expected
+
+
+def test_frame_cache_serves_repeat_decodes_and_evicts_lru(tmp_path: Path) -> None:
+    rel_paths = [p for p in sorted(BASELINE) if BASELINE[p]["kind"] == "pixel"][:3]
+    sizes = [64 + BASELINE[p]["frames"] * BASELINE[p]["width"] * BASELINE[p]["height"] * 3
+             for p in rel_paths]
+    cache = FrameCache(tmp_path / "cache", max_bytes=sizes[1] + sizes[2])
+    copy = tmp_path / "renamed.dat"  # same content under another name shares the entry
+    copy.write_bytes((REPO_ROOT / rel_paths[0]).read_bytes())
+
+    for path in (REPO_ROOT / rel_paths[0], copy):
+        with redirect_stdout(io.StringIO()):
+            bean = PixelBeanDecoder.decode_file(str(path), cache=cache)
+        frames = b"".join(f.tobytes() for f in bean.frames_data)
+        assert _sha256(frames) == BASELINE[rel_paths[0]]["hash"]
+    assert (cache.hits, cache.misses) == (1, 1)
+
+    with redirect_stdout(io.StringIO()):
+        for rel_path in rel_paths[1:]:
+            PixelBeanDecoder.decode_file(str(REPO_ROOT / rel_path), cache=cache)
+    assert cache.size() <= cache.max_bytes
+    with redirect_stdout(io.StringIO()):
+        PixelBeanDecoder.decode_file(str(copy), cache=cache)  # the oldest entry was evicted
+    assert cache.misses == 4
+
+
+def test_frame_cache_discards_entries_truncated_inside_the_header(tmp_path: Path) -> None:
+    rel_path = next(p for p in sorted(BASELINE) if BASELINE[p]["kind"] == "pixel")
+    data = (REPO_ROOT / rel_path).read_bytes()
+    cache = FrameCache(tmp_path / "cache")
+    entry = cache._path(cache.key_for(data))
+    entry.parent.mkdir(parents=True)
+    entry.write_bytes(b"SVFC\0\0")  # e.g. a copy cut short
+
+    with redirect_stdout(io.StringIO()):
+        bean = cache.decode_file(str(REPO_ROOT / rel_path))
+    assert _sha256(b"".join(f.tobytes() for f in bean.frames_data)) == BASELINE[rel_path]["hash"]
+    assert (cache.hits, cache.misses) == (0, 1)
+    assert entry.stat().st_size > 64  # replaced by a fresh entry
+
+
+def test_seek_index_decodes_single_frames(tmp_path: Path) -> None:
+    """Random-access frames (via a persisted sidecar index) match the full decode."""
+    rel_path = max((p for p in BASELINE if BASELINE[p]["kind"] == "pixel"),
+                   key=lambda p: BASELINE[p]["frames"])
+    path = tmp_path / "art.dat"
+    path.write_bytes((REPO_ROOT / rel_path).read_bytes())
+    PixelBeanDecoder.load_frame_index(str(path))  # builds and saves <file>.idx.json
+    index = PixelBeanDecoder.load_frame_index(str(path), persist=False)
+    assert (tmp_path / "art.dat.idx.json").exists()
+    assert index.total_frames == BASELINE[rel_path]["frames"]
+
+    bean = PixelBeanDecoder.decode_file(str(path))
+    with open(path, "rb") as fp:
+        for k in (0, index.checkpoint_every + 1, index.total_frames - 1):
+            assert (PixelBeanDecoder.decode_frame(fp, k, index) == bean.frames_data[k]).all()
@@ -10,18 +10,24 @@ from __future__ import annotations
 
 import io
 import struct
+from concurrent.futures import ThreadPoolExecutor
 from contextlib import redirect_stdout
 
 import numpy as np
+import pytest
 import zstandard
+from Crypto.Cipher import AES
 from PIL import Image
 
-from servoom.pixel_bean_decoder import PixelBeanDecoder
+from servoom.pixel_bean_decoder import (
+    AnimMultiDecoder, BaseDecoder, Decoder0x1A, DecoderContext, FileFormat,
+    PixelBeanDecoder, register_kernels,
+)
 
 
-def _decode(raw: bytes):
+def _decode(raw: bytes, executor=None):
     with redirect_stdout(io.StringIO()):
-        return PixelBeanDecoder.decode_stream(io.BytesIO(raw))
+        return PixelBeanDecoder.decode_stream(io.BytesIO(raw), executor)
 
 
 def test_format_42_zstd_raw_rgb_roundtrips_exactly():
@@ -64,3 +70,166 @@ def test_format_26_64x64_solid_0x0c_frame():
     assert bean.total_frames == 1
     assert (bean.width, bean.height) == (64, 64)
     assert np.array_equal(bean.frames_data[0], np.full((64, 64, 3), (123, 45, 67), np.uint8))
+
+
+def test_format_9_aes_frames_decrypt_with_reused_context():
+    frames = [bytes((i * 7 + f) % 256 for i in range(768)) for f in range(3)]
+    cipher = AES.new(BaseDecoder.AES_SECRET_KEY.encode(), AES.MODE_CBC, BaseDecoder.AES_IV)
+    raw = bytes([9, 0]) + struct.pack(">H", 80) + cipher.encrypt(b"".join(frames))
+
+    context = DecoderContext()
+    for _ in range(2):  # the second pass reuses the context's cipher and plan
+        with redirect_stdout(io.StringIO()):
+            bean = PixelBeanDecoder.decode_stream(io.BytesIO(raw), context=context)
+        assert (bean.total_frames, bean.speed) == (3, 80)
+        for got, want in zip(bean.frames_data, frames):
+            assert got.tobytes() == want
+
+
+def test_compact_reorders_16x16_tiles_to_raster():
+    # 32x32 = 2x2 tiles in stream order (row-major); pixel = (tile*40, index-in-tile, 7).
+    stream = b"".join(bytes([t * 40, i, 7]) for t in range(4) for i in range(256))
+    frame = AnimMultiDecoder(io.BytesIO())._compact([stream], 1, row_count=2, column_count=2)[0]
+
+    assert frame.shape == (32, 32, 3)
+    for t in range(4):
+        ty, tx = divmod(t, 2)
+        tile = frame[ty * 16:(ty + 1) * 16, tx * 16:(tx + 1) * 16]
+        assert np.all(tile[..., 0] == t * 40)
+        assert np.array_equal(tile[..., 1], np.arange(256, dtype=np.uint8).reshape(16, 16))
+
+
+def _frame_0x1a(encrypt_type: int, colors, pixels: bytes) -> bytes:
+    """[4-byte header][0xAA][u16 LE payload_len][2 bytes][type][u16 LE n][n*RGB][pixels]."""
+    body = (bytes([encrypt_type]) + struct.pack("<H", len(colors))
+            + b"".join(bytes(c) for c in colors) + pixels)
+    return b"\x00" * 4 + bytes([0xAA]) + struct.pack("<H", 5 + len(body)) + b"\x00\x00" + body
+
+
+def test_format_26_parallel_0x1a_matches_sequential_after_failed_frame():
+    # Frame 1's pixel walk fails, so its appended colour must NOT reach frame 2's palette;
+    # the parallel scan speculates otherwise and has to re-decode frame 2.
+    frames = [
+        _frame_0x1a(0x15, [(255, 0, 0)], b"\x00\x00"),  # solid red (0 bpp)
+        _frame_0x1a(0x13, [(0, 255, 0)], b"\x00"),  # truncated -> duplicates frame 0
+        _frame_0x1a(0x13, [(0, 0, 255)], b"\x00" + bytes([0b10101010]) * 1024),
+    ]
+    raw = struct.pack(">BHBB", 3, 100, 4, 4) + b"".join(frames)
+
+    with redirect_stdout(io.StringIO()):
+        sequential = Decoder0x1A(io.BytesIO(raw)).decode()
+        with ThreadPoolExecutor(max_workers=2) as executor:
+            parallel = Decoder0x1A(io.BytesIO(raw), executor).decode()
+
+    assert parallel.total_frames == sequential.total_frames == 3
+    for got, expected in zip(parallel.frames_data, sequential.frames_data):
+        assert np.array_equal(got, expected)
+    assert np.array_equal(sequential.frames_data[1], sequential.frames_data[0])
+    colors = {tuple(c) for c in sequential.frames_data[2].reshape(-1, 3)}
+    assert colors == {(255, 0, 0), (0, 0, 255)}  # palette is [red, blue], not [red, green, blue]
+
+
+def _solid_0x0c(rgb) -> bytes:
+    frame = bytes([0xAA, 0x0B, 0x00, 0xF4, 0x01, 0x0C, 0x01, 0x00, *rgb])
+    return struct.pack(">I", len(frame)) + frame
+
+
+def test_format_26_0x0c_frames_decode_in_order_on_executor():
+    colors = [(200, 0, 0), (0, 200, 0), (0, 0, 200), (50, 60, 70)]
+    raw = struct.pack(">BHBB", len(colors), 100, 4, 4) + b"".join(map(_solid_0x0c, colors))
+    broken = bytes([len(colors) + 1]) + raw[1:] + struct.pack(">I", 3) + b"\xAA\x00\x00"
+
+    with ThreadPoolExecutor(max_workers=3) as executor:
+        bean = _decode(bytes([26]) + raw, executor)
+        # Same frames through Decoder0x1A's 0x0C path; the short last frame duplicates the
+        # previous one and ends the animation, exactly like the sequential decode.
+        seq = Decoder0x1A(io.BytesIO(broken)).decode()
+        par = Decoder0x1A(io.BytesIO(broken), executor).decode()
+
+    assert [tuple(f[0, 0]) for f in bean.frames_data] == colors
+    assert par.total_frames == seq.total_frames == len(colors) + 1
+    for got, expected in zip(par.frames_data, seq.frames_data):
+        assert np.array_equal(got, expected)
+
+
+def test_format_26_64x64_frame_access_fails_like_the_full_decode():
+    bad = struct.pack(">I", 9) + b"\xAA" * 9  # not a 0x0C frame
+    raw = (bytes([26]) + struct.pack(">BHBB", 3, 100, 4, 4)
+           + _solid_0x0c((1, 2, 3)) + bad + _solid_0x0c((4, 5, 6)))
+    with pytest.raises(Exception, match="Expected 0x0C") as full:
+        _decode(raw)
+    index = PixelBeanDecoder.build_frame_index(io.BytesIO(raw))
+    for k in range(3):
+        with pytest.raises(Exception) as single:
+            PixelBeanDecoder.decode_frame(io.BytesIO(raw), k, index)
+        assert str(single.value) == str(full.value)
+
+
+def test_format_26_frame_access_reuses_a_caller_context():
+    raw = (bytes([26]) + struct.pack(">BHBB", 2, 100, 4, 4)
+           + _solid_0x0c((1, 2, 3)) + _solid_0x0c((4, 5, 6)))
+    bean = _decode(raw)
+    index = PixelBeanDecoder.build_frame_index(io.BytesIO(raw))
+    context = DecoderContext()
+    for k in (1, 0, 1):  # later calls reuse the context's reorder plan
+        frame = PixelBeanDecoder.decode_frame(io.BytesIO(raw), k, index, context=context)
+        assert (frame == bean.frames_data[k]).all()
+    assert context._plans
+
+
+def test_format_26_0x1a_decodes_with_the_caller_context():
+    # 128x128 (four 64x64 nodes, ctrl 0): solid red, then 0x13 appends blue with 1 bpp.
+    frames = [
+        _frame_0x1a(0x15, [(255, 0, 0)], b"\x00" * 5),  # a node header reads 2 bytes
+        _frame_0x1a(0x13, [(0, 0, 255)], (b"\x00" + bytes([0b10101010]) * 512) * 4),
+    ]
+    raw = bytes([26]) + struct.pack(">BHBB", 2, 100, 8, 8) + b"".join(frames)
+    bean = _decode(raw)
+    assert {tuple(c) for c in bean.frames_data[1].reshape(-1, 3)} == {(255, 0, 0), (0, 0, 255)}
+
+    for decode in (
+        lambda ctx: PixelBeanDecoder.decode_stream(io.BytesIO(raw), context=ctx).frames_data,
+        lambda ctx: [PixelBeanDecoder.decode_frame(io.BytesIO(raw), k, context=ctx)
+                     for k in range(2)],
+    ):
+        context = DecoderContext()
+        with redirect_stdout(io.StringIO()):
+            got = decode(context)
+        for frame, want in zip(got, bean.frames_data):
+            assert np.array_equal(frame, want)
+        # The quadtree walk used this context's plan, not the thread's own
+        assert list(context._plans) == [(FileFormat.ANIM_MULTIPLE_64, 128, 128)]
+        assert 64 in context._plans[(FileFormat.ANIM_MULTIPLE_64, 128, 128)]._node_offsets
+
+
+def test_registered_kernels_replace_the_pixel_loops():
+    # The browser build swaps in JS kernels; a registered kernel must see the quadtree
+    # bytes after the palette plus the flat palette, and None must mean "invalid frame".
+    frames = [
+        _frame_0x1a(0x15, [(255, 0, 0), (0, 0, 255)], b"\x00" + bytes([0b10101010]) * 512),
+        _frame_0x1a(0x13, [(0, 255, 0)], b"\x00" + bytes(1024)),
+    ]
+    raw = struct.pack(">BHBB", 2, 100, 4, 4) + b"".join(frames)
+    expected = Decoder0x1A(io.BytesIO(raw)).decode()
+    calls = []
+
+    def decode_0x1a_pixels(pixel, width, height, palette):
+        calls.append((bytes(pixel[:1]), width, height, bytes(palette)))
+        return None if len(calls) == 2 else bytes([7]) * width * height * 3
+
+    register_kernels(decode_0x1a_pixels=decode_0x1a_pixels,
+                     decode_0x0c_frame=lambda data, num_pixels: bytes([9]) * num_pixels * 3)
+    try:
+        bean = Decoder0x1A(io.BytesIO(raw)).decode()
+        solid = _decode(bytes([26]) + struct.pack(">BHBB", 1, 100, 4, 4) + _solid_0x0c((1, 2, 3)))
+    finally:
+        register_kernels(decode_0x1a_pixels=None, decode_0x0c_frame=None)
+
+    assert calls == [(b"\x00", 64, 64, bytes([255, 0, 0, 0, 0, 255])),
+                     (b"\x00", 64, 64, bytes([255, 0, 0, 0, 0, 255, 0, 255, 0]))]
+    assert np.all(bean.frames_data[0] == 7) and np.all(bean.frames_data[1] == 7)  # None repeats
+    assert np.all(solid.frames_data[0] == 9)
+    restored = Decoder0x1A(io.BytesIO(raw)).decode()
+    assert all(np.array_equal(a, b) for a, b in zip(restored.frames_data, expected.frames_data))
+    with pytest.raises(ValueError):
+        register_kernels(decode_0x1f=None)